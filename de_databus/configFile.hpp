@@ -5,8 +5,7 @@
 #include <sstream>
 #include <fstream>     
 #include <filesystem>  
-#include "../helpers/json_nlohmann.hpp"
-using Json_de = nlohmann::json;
+#include "../helpers/json_de.hpp"
 
 namespace de
 {
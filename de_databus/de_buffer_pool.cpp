@@ -0,0 +1,74 @@
+#include <atomic>
+
+#include "de_buffer_pool.hpp"
+
+using namespace de::comm;
+
+
+static std::atomic<uint64_t> s_hits {0};
+static std::atomic<uint64_t> s_misses {0};
+static std::atomic<uint64_t> s_discards {0};
+
+
+static inline std::size_t getClassSize (const int size_class)
+{
+    return static_cast<std::size_t>(BUFFER_POOL_MIN_SIZE) << (2 * size_class);
+}
+
+
+std::string CBufferPool::acquire (const std::size_t size_hint)
+{
+    int size_class = 0;
+    while ((size_class < BUFFER_POOL_SIZE_CLASSES) && (getClassSize(size_class) < size_hint)) ++size_class;
+
+    for (int i = size_class; i < BUFFER_POOL_SIZE_CLASSES; ++i)
+    {
+        std::vector<std::string>& free_buffers = m_free_buffers[i];
+        if (free_buffers.empty()) continue;
+
+        std::string buffer = std::move(free_buffers.back());
+        free_buffers.pop_back();
+        s_hits.fetch_add(1, std::memory_order_relaxed);
+        return buffer;
+    }
+
+    s_misses.fetch_add(1, std::memory_order_relaxed);
+
+    std::string buffer;
+    buffer.reserve((size_class < BUFFER_POOL_SIZE_CLASSES) ? getClassSize(size_class) : size_hint);
+    return buffer;
+}
+
+
+void CBufferPool::release (std::string&& buffer)
+{
+    const std::size_t capacity = buffer.capacity();
+
+    // moved from or small strings are not worth keeping.
+    if (capacity < BUFFER_POOL_MIN_SIZE) return ;
+
+    int size_class = BUFFER_POOL_SIZE_CLASSES - 1;
+    while (getClassSize(size_class) > capacity) --size_class;
+
+    std::vector<std::string>& free_buffers = m_free_buffers[size_class];
+    if ((free_buffers.size() >= BUFFER_POOL_MAX_FREE_BUFFERS) || (capacity > 2 * getClassSize(BUFFER_POOL_SIZE_CLASSES - 1)))
+    {
+        s_discards.fetch_add(1, std::memory_order_relaxed);
+        return ;
+    }
+
+    if (free_buffers.capacity() == 0) free_buffers.reserve(BUFFER_POOL_MAX_FREE_BUFFERS);
+
+    buffer.clear();
+    free_buffers.push_back(std::move(buffer));
+}
+
+
+BUFFER_POOL_STATISTICS CBufferPool::getStatistics ()
+{
+    BUFFER_POOL_STATISTICS statistics;
+    statistics.hits = s_hits.load(std::memory_order_relaxed);
+    statistics.misses = s_misses.load(std::memory_order_relaxed);
+    statistics.discards = s_discards.load(std::memory_order_relaxed);
+    return statistics;
+}
@@ -0,0 +1,80 @@
+#ifndef DE_BUFFER_POOL_H_
+#define DE_BUFFER_POOL_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// number of size classes. class i holds buffers of at least (BUFFER_POOL_MIN_SIZE << (2*i)) bytes.
+#define BUFFER_POOL_SIZE_CLASSES            5
+#define BUFFER_POOL_MIN_SIZE                256
+// free buffers kept per size class and thread.
+#define BUFFER_POOL_MAX_FREE_BUFFERS        8
+
+
+typedef struct
+{
+    // acquire served by a free buffer.
+    uint64_t hits;
+    // acquire had to allocate.
+    uint64_t misses;
+    // released buffers dropped because their class was full or they were too big.
+    uint64_t discards;
+} BUFFER_POOL_STATISTICS;
+
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief thread local pool of message buffers grouped by size class.
+     * @details buffers are std::string so they can be moved into queues and
+     * APIs that take strings. A buffer keeps its capacity while it is in the pool,
+     * so after warm up serializing a message reuses memory instead of calling malloc.
+     * Buffers released on another thread go to that thread's pool.
+     */
+    class CBufferPool
+    {
+        public:
+
+            static CBufferPool& getThreadInstance ()
+            {
+                static thread_local CBufferPool instance;
+
+                return instance;
+            }
+
+            CBufferPool(CBufferPool const&)       = delete;
+            void operator=(CBufferPool const&)    = delete;
+
+        private:
+
+            CBufferPool() {};
+
+        public:
+
+            /**
+             * @brief returns an empty buffer with capacity of at least size_hint.
+             * @details a buffer from the first non empty class at or above size_hint is used,
+             * so buffers that grew while in use are found again by small hints.
+             */
+            std::string acquire (const std::size_t size_hint);
+
+            void release (std::string&& buffer);
+
+            /**
+             * @brief hit and miss counts of all threads.
+             */
+            static BUFFER_POOL_STATISTICS getStatistics ();
+
+        private:
+
+            std::vector<std::string> m_free_buffers[BUFFER_POOL_SIZE_CLASSES];
+    };
+
+}
+}
+
+#endif
@@ -0,0 +1,204 @@
+#include <charconv>
+
+#include "de_delta_codec.hpp"
+
+using namespace de::comm;
+
+
+bool de::comm::createMergePatch (const Json_de& base, const Json_de& value, Json_de& patch)
+{
+    if (!value.is_object()) return false;
+
+    patch = Json_de::object();
+    const bool base_is_object = base.is_object();
+
+    for (const auto& member : value.items())
+    {
+        // null means "remove" in a merge patch.
+        if (member.value().is_null()) return false;
+
+        if (!base_is_object || !base.contains(member.key()))
+        {
+            patch[member.key()] = member.value();
+            continue;
+        }
+
+        const Json_de& base_member = base[member.key()];
+        if (base_member == member.value()) continue;
+
+        if (base_member.is_object() && member.value().is_object())
+        {
+            Json_de nested_patch;
+            if (!createMergePatch(base_member, member.value(), nested_patch)) return false;
+            patch[member.key()] = std::move(nested_patch);
+        }
+        else if (member.value().is_object())
+        {
+            // an object patch merges into what the receiver has. Send a clean object instead.
+            Json_de nested_patch;
+            if (!createMergePatch(Json_de(), member.value(), nested_patch)) return false;
+            patch[member.key()] = std::move(nested_patch);
+        }
+        else
+        {
+            patch[member.key()] = member.value();
+        }
+    }
+
+    if (base_is_object)
+    {
+        for (const auto& member : base.items())
+        {
+            if (!value.contains(member.key())) patch[member.key()] = nullptr;
+        }
+    }
+
+    return true;
+}
+
+
+bool de::comm::parseDeltaHeader (const char * begin, const char * end, DELTA_HEADER& header)
+{
+    // [sequence] or [sequence,base_sequence] as written by CModule.
+    if ((end - begin < 3) || (*begin != '[') || (end[-1] != ']')) return false;
+
+    const char * p = begin + 1;
+    const char * const last = end - 1;
+
+    unsigned int sequence = 0;
+    std::from_chars_result result = std::from_chars(p, last, sequence);
+    if ((result.ec != std::errc()) || (sequence > 0xFFFF)) return false;
+
+    header.sequence = static_cast<uint16_t>(sequence);
+    header.base_sequence = header.sequence;
+    header.keyframe = (result.ptr == last);
+    if (header.keyframe) return true;
+
+    if (*result.ptr != ',') return false;
+    unsigned int base_sequence = 0;
+    result = std::from_chars(result.ptr + 1, last, base_sequence);
+    if ((result.ec != std::errc()) || (result.ptr != last) || (base_sequence > 0xFFFF)) return false;
+
+    header.base_sequence = static_cast<uint16_t>(base_sequence);
+    return true;
+}
+
+
+const Json_de& CDeltaEncoder::encode (const PARTY_HANDLE target_party, const int andruav_message_id,
+                                      const Json_de& message_cmd, const DELTA_ENCODING_CONFIG& config, DELTA_HEADER& header)
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    std::map<std::pair<int, PARTY_HANDLE>, DELTA_STREAM>::iterator it = m_streams.find(std::make_pair(andruav_message_id, target_party));
+    const bool is_new_stream = (it == m_streams.end());
+    if (is_new_stream)
+    {
+        it = m_streams.emplace(std::make_pair(andruav_message_id, target_party), DELTA_STREAM()).first;
+        it->second.sequence = 0;
+    }
+    else
+    {
+        ++it->second.sequence;
+    }
+
+    DELTA_STREAM& stream = it->second;
+    header.sequence = stream.sequence;
+    header.base_sequence = stream.sequence;
+
+    bool keyframe = is_new_stream
+                 || (stream.since_keyframe + 1 >= config.keyframe_interval)
+                 || ((config.keyframe_period_ms != 0) && (now - stream.keyframe_time >= std::chrono::milliseconds(config.keyframe_period_ms)));
+
+    if (!keyframe)
+    {
+        const bool from_keyframe = (config.reference == DELTA_REFERENCE_KEYFRAME);
+        keyframe = !createMergePatch(from_keyframe ? stream.keyframe : stream.last, message_cmd, m_patch);
+        header.base_sequence = from_keyframe ? stream.keyframe_sequence : static_cast<uint16_t>(stream.sequence - 1);
+    }
+
+    header.keyframe = keyframe;
+    if (keyframe)
+    {
+        header.base_sequence = stream.sequence;
+        stream.keyframe = message_cmd;
+        stream.keyframe_sequence = stream.sequence;
+        stream.keyframe_time = now;
+        stream.since_keyframe = 0;
+        ++m_keyframes_sent;
+    }
+    else
+    {
+        ++stream.since_keyframe;
+        ++m_deltas_sent;
+    }
+
+    if (config.reference == DELTA_REFERENCE_PREVIOUS) stream.last = message_cmd;
+
+    return keyframe ? message_cmd : m_patch;
+}
+
+
+void CDeltaEncoder::removeParty (const PARTY_HANDLE target_party)
+{
+    for (std::map<std::pair<int, PARTY_HANDLE>, DELTA_STREAM>::iterator it = m_streams.begin(); it != m_streams.end(); )
+    {
+        if (it->first.second == target_party) it = m_streams.erase(it);
+        else ++it;
+    }
+}
+
+
+bool CDeltaDecoder::decode (const std::string& stream_key, const DELTA_HEADER& header, Json_de& message_cmd)
+{
+    std::map<std::string, DELTA_STREAM, std::less<>>::iterator it = m_streams.find(stream_key);
+
+    if (header.keyframe)
+    {
+        if (it == m_streams.end())
+        {
+            if (m_streams.size() >= DELTA_MAX_STREAMS) m_streams.clear();
+            it = m_streams.emplace(stream_key, DELTA_STREAM()).first;
+        }
+
+        DELTA_STREAM& stream = it->second;
+        stream.last = message_cmd;
+        stream.keyframe = message_cmd;
+        stream.sequence = header.sequence;
+        stream.keyframe_sequence = header.sequence;
+        stream.synchronized = true;
+        return true;
+    }
+
+    if ((it == m_streams.end()) || !it->second.synchronized)
+    {
+        ++m_deltas_dropped;
+        return false;
+    }
+
+    DELTA_STREAM& stream = it->second;
+    const Json_de * base = nullptr;
+    if (header.base_sequence == stream.keyframe_sequence)
+    {
+        base = &stream.keyframe;
+    }
+    else if (header.base_sequence == stream.sequence)
+    {
+        base = &stream.last;
+    }
+    else
+    {
+        // the message this delta refers to was lost. Wait for the next keyframe.
+        stream.synchronized = false;
+        ++m_deltas_dropped;
+        return false;
+    }
+
+    Json_de full = *base;
+    full.merge_patch(message_cmd);
+    message_cmd = full;
+    stream.last = std::move(full);
+    stream.sequence = header.sequence;
+
+    ++m_deltas_rebuilt;
+    return true;
+}
@@ -0,0 +1,174 @@
+#ifndef DE_DELTA_CODEC_H_
+#define DE_DELTA_CODEC_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "../helpers/json_de.hpp"
+
+#include "de_party_table.hpp"
+
+
+// receiver forgets all streams when it tracks more than this. They recover at their next keyframe.
+#define DELTA_MAX_STREAMS       1024
+
+
+/**
+ * @brief what a delta is computed against.
+ * DELTA_REFERENCE_PREVIOUS: previous message of the stream. Smallest deltas but a lost
+ *      message makes the following deltas undecodable until the next keyframe.
+ * DELTA_REFERENCE_KEYFRAME: last keyframe. Deltas grow as the values drift away from the keyframe
+ *      but a lost delta does not affect the others.
+ */
+typedef enum {
+    DELTA_REFERENCE_PREVIOUS    = 0,
+    DELTA_REFERENCE_KEYFRAME    = 1
+} ENUM_DELTA_REFERENCE;
+
+
+typedef struct
+{
+    // a keyframe is sent every keyframe_interval messages.
+    uint32_t keyframe_interval;
+    // a keyframe is also sent when the last one is older than this. zero means no time limit.
+    uint32_t keyframe_period_ms;
+    ENUM_DELTA_REFERENCE reference;
+} DELTA_ENCODING_CONFIG;
+
+
+/**
+ * @brief @link INTERMODULE_DELTA_HEADER @endlink field. [sequence] for keyframes and [sequence, base_sequence] for deltas.
+ */
+typedef struct
+{
+    uint16_t sequence;
+    uint16_t base_sequence;
+    bool keyframe;
+} DELTA_HEADER;
+
+
+typedef struct
+{
+    // sender side
+    uint64_t keyframes_sent;
+    uint64_t deltas_sent;
+    // receiver side
+    uint64_t deltas_rebuilt;
+    // deltas dropped because the message they refer to was lost.
+    uint64_t deltas_dropped;
+} DELTA_ENCODING_COUNTERS;
+
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief JSON merge patch (RFC 7386) that turns base into value.
+     * @details nested objects are diffed recursively, any other changed value is replaced as a whole
+     * and removed members are set to null.
+     * @return false if value is not an object or has null members, which a merge patch can not express.
+     */
+    bool createMergePatch (const Json_de& base, const Json_de& value, Json_de& patch);
+
+    /**
+     * @brief parses @link INTERMODULE_DELTA_HEADER @endlink value text.
+     */
+    bool parseDeltaHeader (const char * begin, const char * end, DELTA_HEADER& header);
+
+
+    /**
+     * @brief sender side of delta encoding. One stream per message type and target.
+     * @details not thread safe. CModule uses it while holding its lock.
+     */
+    class CDeltaEncoder
+    {
+        public:
+
+            /**
+             * @brief returns what to send as message_cmd and fills its header.
+             * @return message_cmd itself for keyframes otherwise a merge patch owned by the encoder
+             * that is valid until the next call.
+             */
+            const Json_de& encode (const PARTY_HANDLE target_party, const int andruav_message_id,
+                                   const Json_de& message_cmd, const DELTA_ENCODING_CONFIG& config, DELTA_HEADER& header);
+
+            /**
+             * @brief next message of every stream is a keyframe.
+             */
+            inline void reset () { m_streams.clear(); }
+
+            /**
+             * @brief drops streams of a party evicted from CPartyTable as its handle is reused.
+             */
+            void removeParty (const PARTY_HANDLE target_party);
+
+            inline uint64_t getKeyframesSent () const { return m_keyframes_sent; }
+            inline uint64_t getDeltasSent () const { return m_deltas_sent; }
+
+        private:
+
+            typedef struct
+            {
+                Json_de last;
+                Json_de keyframe;
+                uint16_t sequence;
+                uint16_t keyframe_sequence;
+                uint32_t since_keyframe;
+                std::chrono::steady_clock::time_point keyframe_time;
+            } DELTA_STREAM;
+
+            std::map<std::pair<int, PARTY_HANDLE>, DELTA_STREAM> m_streams;
+            Json_de m_patch;
+
+            uint64_t m_keyframes_sent = 0;
+            uint64_t m_deltas_sent = 0;
+    };
+
+
+    /**
+     * @brief receiver side of delta encoding. Rebuilds full messages from keyframes and deltas.
+     * @details used by the receive thread only. Counters can be read from any thread.
+     */
+    class CDeltaDecoder
+    {
+        public:
+
+            /**
+             * @param stream_key identifies sender, target and message type.
+             * @param message_cmd received "ms". Replaced by the full "ms" when true is returned.
+             * @return false if the message a delta refers to was lost. The delta must be dropped.
+             */
+            bool decode (const std::string& stream_key, const DELTA_HEADER& header, Json_de& message_cmd);
+
+            inline void reset () { m_streams.clear(); }
+
+            inline uint64_t getDeltasRebuilt () const { return m_deltas_rebuilt; }
+            inline uint64_t getDeltasDropped () const { return m_deltas_dropped; }
+
+        private:
+
+            typedef struct
+            {
+                Json_de last;
+                Json_de keyframe;
+                uint16_t sequence;
+                uint16_t keyframe_sequence;
+                // false after a lost base until the next keyframe.
+                bool synchronized;
+            } DELTA_STREAM;
+
+            std::map<std::string, DELTA_STREAM, std::less<>> m_streams;
+
+            std::atomic<uint64_t> m_deltas_rebuilt{0};
+            std::atomic<uint64_t> m_deltas_dropped{0};
+    };
+}
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifdef DE_ENABLE_ZSTD
+#include <memory>
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+#include "de_dictionary_codec.hpp"
+
+using namespace de::comm;
+
+
+#ifdef DE_ENABLE_ZSTD
+
+/**
+ * @brief zstd contexts of the calling thread. Contexts keep their buffers between messages.
+ */
+static ZSTD_CCtx * getCompressionContext ()
+{
+    struct CDeleter { void operator() (ZSTD_CCtx * context) const { ZSTD_freeCCtx(context); } };
+    static thread_local std::unique_ptr<ZSTD_CCtx, CDeleter> context(ZSTD_createCCtx());
+
+    return context.get();
+}
+
+
+static ZSTD_DCtx * getDecompressionContext ()
+{
+    struct CDeleter { void operator() (ZSTD_DCtx * context) const { ZSTD_freeDCtx(context); } };
+    static thread_local std::unique_ptr<ZSTD_DCtx, CDeleter> context(ZSTD_createDCtx());
+
+    return context.get();
+}
+
+#endif
+
+
+CDictionaryCodec::~CDictionaryCodec ()
+{
+#ifdef DE_ENABLE_ZSTD
+    ZSTD_freeCDict(m_compression_dictionary);
+    ZSTD_freeDDict(m_decompression_dictionary);
+#endif
+}
+
+
+bool CDictionaryCodec::load (const std::string& dictionary)
+{
+#ifdef DE_ENABLE_ZSTD
+    if (isLoaded()) return false;
+
+    const uint32_t dictionary_id = ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size());
+    // raw content dictionaries have no id so they can not be versioned.
+    if (dictionary_id == 0) return false;
+
+    m_compression_dictionary = ZSTD_createCDict(dictionary.data(), dictionary.size(), DICTIONARY_COMPRESSION_LEVEL);
+    m_decompression_dictionary = ZSTD_createDDict(dictionary.data(), dictionary.size());
+    if ((m_compression_dictionary == nullptr) || (m_decompression_dictionary == nullptr))
+    {
+        ZSTD_freeCDict(m_compression_dictionary);
+        ZSTD_freeDDict(m_decompression_dictionary);
+        m_compression_dictionary = nullptr;
+        m_decompression_dictionary = nullptr;
+        return false;
+    }
+
+    m_dictionary_id = dictionary_id;
+    return true;
+#else
+    (void)dictionary;
+    return false;
+#endif
+}
+
+
+bool CDictionaryCodec::compress (const char * data, const std::size_t length, std::string& out) const
+{
+#ifdef DE_ENABLE_ZSTD
+    if (!isLoaded()) return false;
+
+    const std::size_t offset = out.length();
+    out.resize(offset + ZSTD_compressBound(length));
+
+    const std::size_t size = ZSTD_compress_usingCDict(getCompressionContext(), &out[offset], out.length() - offset, data, length, m_compression_dictionary);
+    if (ZSTD_isError(size))
+    {
+        out.resize(offset);
+        return false;
+    }
+
+    out.resize(offset + size);
+    return true;
+#else
+    (void)data;
+    (void)length;
+    (void)out;
+    return false;
+#endif
+}
+
+
+bool CDictionaryCodec::decompress (const char * data, const std::size_t length, std::string& out) const
+{
+#ifdef DE_ENABLE_ZSTD
+    if (!isLoaded()) return false;
+    if (ZSTD_getDictID_fromFrame(data, length) != m_dictionary_id) return false;
+
+    const unsigned long long content_size = ZSTD_getFrameContentSize(data, length);
+    if ((content_size == ZSTD_CONTENTSIZE_UNKNOWN) || (content_size == ZSTD_CONTENTSIZE_ERROR)) return false;
+    if (content_size > DICTIONARY_MAX_DECOMPRESSED_SIZE) return false;
+
+    const std::size_t offset = out.length();
+    out.resize(offset + content_size);
+
+    const std::size_t size = ZSTD_decompress_usingDDict(getDecompressionContext(), &out[offset], content_size, data, length, m_decompression_dictionary);
+    if (ZSTD_isError(size) || (size != content_size))
+    {
+        out.resize(offset);
+        return false;
+    }
+
+    return true;
+#else
+    (void)data;
+    (void)length;
+    (void)out;
+    return false;
+#endif
+}
+
+
+bool CDictionaryCodec::train (const std::vector<std::string>& samples, const std::size_t dictionary_size, std::string& dictionary)
+{
+#ifdef DE_ENABLE_ZSTD
+    std::string samples_buffer;
+    std::vector<std::size_t> sample_sizes;
+    sample_sizes.reserve(samples.size());
+    for (const std::string& sample : samples)
+    {
+        samples_buffer += sample;
+        sample_sizes.push_back(sample.length());
+    }
+
+    dictionary.resize(dictionary_size);
+    const std::size_t size = ZDICT_trainFromBuffer(&dictionary[0], dictionary.size(), samples_buffer.data(), sample_sizes.data(), static_cast<unsigned>(sample_sizes.size()));
+    if (ZDICT_isError(size))
+    {
+        dictionary.clear();
+        return false;
+    }
+
+    dictionary.resize(size);
+    return true;
+#else
+    (void)samples;
+    (void)dictionary_size;
+    dictionary.clear();
+    return false;
+#endif
+}
@@ -0,0 +1,92 @@
+#ifndef DE_DICTIONARY_CODEC_H_
+#define DE_DICTIONARY_CODEC_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+// zstd level used with the dictionary. On small messages higher levels are slower without compressing better.
+#ifndef DICTIONARY_COMPRESSION_LEVEL
+#define DICTIONARY_COMPRESSION_LEVEL        3
+#endif
+
+// decompressed size limit. Larger frames are rejected.
+#define DICTIONARY_MAX_DECOMPRESSED_SIZE    (16 * 1024 * 1024)
+
+
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief zstd compression of small messages with a pre-trained dictionary.
+     * @details available when built with DE_ENABLE_ZSTD and linked with libzstd.
+     * Otherwise load() fails and the databus stays uncompressed.
+     *
+     * A dictionary is trained offline from captured messages using train().
+     * Its zstd dictionary id is the dictionary version: it is negotiated in
+     * TYPE_AndruavModule_ID and recorded in every compressed frame.
+     *
+     * The object is immutable once loaded and can be used from any thread.
+     * Compression contexts are kept per thread.
+     */
+    class CDictionaryCodec
+    {
+        public:
+
+            CDictionaryCodec () = default;
+            ~CDictionaryCodec ();
+
+            CDictionaryCodec(CDictionaryCodec const&)       = delete;
+            void operator=(CDictionaryCodec const&)         = delete;
+
+        public:
+
+            /**
+             * @param dictionary content of a dictionary file produced by train().
+             * @return false if dictionary is invalid or zstd support is not built in.
+             */
+            bool load (const std::string& dictionary);
+
+            inline bool isLoaded () const { return m_compression_dictionary != nullptr; }
+
+            /**
+             * @brief dictionary version. 0 if not loaded.
+             */
+            inline uint32_t getDictionaryId () const { return m_dictionary_id; }
+
+            /**
+             * @brief appends compressed data to out.
+             * @return false on error. out is left unchanged.
+             */
+            bool compress (const char * data, const std::size_t length, std::string& out) const;
+
+            /**
+             * @brief appends decompressed data to out.
+             * @return false if data was compressed with another dictionary or is malformed.
+             */
+            bool decompress (const char * data, const std::size_t length, std::string& out) const;
+
+            /**
+             * @brief trains a dictionary from sample messages.
+             * @param dictionary_size maximum dictionary size. 16KB to 64KB fits DroneEngage traffic.
+             * @return false if there are too few samples or zstd support is not built in.
+             */
+            static bool train (const std::vector<std::string>& samples, const std::size_t dictionary_size, std::string& dictionary);
+
+        private:
+
+            ZSTD_CDict_s * m_compression_dictionary = nullptr;
+            ZSTD_DDict_s * m_decompression_dictionary = nullptr;
+            uint32_t m_dictionary_id = 0;
+    };
+}
+}
+
+#endif
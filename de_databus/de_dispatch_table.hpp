@@ -0,0 +1,78 @@
+#ifndef DE_DISPATCH_TABLE_H_
+#define DE_DISPATCH_TABLE_H_
+
+#include <array>
+#include <unordered_map>
+
+#include "de_message_registry.hpp"
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief maps message types, or remote execute commands, to handlers.
+     * @details registered message types are stored in a flat array indexed by
+     * their MESSAGE_TYPE_REGISTRY slot. Other ids, i.e. user range messages and
+     * RemoteCommand_* values, go to a hash map.
+     *
+     * Handler is any type that is default constructible and testable as bool,
+     * such as std::function or a function pointer.
+     * Handlers are registered at startup and the table is not locked.
+     */
+    template <typename Handler>
+    class CDispatchTable
+    {
+        public:
+
+            void setHandler (const int id, Handler handler)
+            {
+                const int slot = getMessageTypeSlot(id);
+                if (slot != -1)
+                {
+                    m_slots[slot] = std::move(handler);
+                    return ;
+                }
+
+                if (handler)
+                {
+                    m_others[id] = std::move(handler);
+                }
+                else
+                {
+                    m_others.erase(id);
+                }
+            }
+
+            void removeHandler (const int id)
+            {
+                setHandler(id, Handler());
+            }
+
+            /**
+             * @return registered handler or nullptr.
+             */
+            const Handler * findHandler (const int id) const
+            {
+                const int slot = getMessageTypeSlot(id);
+                if (slot != -1)
+                {
+                    const Handler& handler = m_slots[slot];
+                    return handler ? &handler : nullptr;
+                }
+
+                if (m_others.empty()) return nullptr;
+
+                const auto it = m_others.find(id);
+                return (it == m_others.end()) ? nullptr : &it->second;
+            }
+
+        private:
+
+            std::array<Handler, MESSAGE_TYPE_COUNT> m_slots {};
+            std::unordered_map<int, Handler> m_others;
+    };
+}
+}
+
+#endif
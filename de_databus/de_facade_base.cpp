@@ -73,4 +73,16 @@ void CFacade_Base::API_sendConfigTemplate(const std::string& target_party_id, co
 #endif    
 
     return ;
-}
\ No newline at end of file
+}
+
+
+void CFacade_Base::API_defineValueStream(const std::string& target_party_id, const int andruav_message_id, const CValueStreamDescriptor& descriptor, const uint32_t window_ms, const uint16_t max_records) const
+{
+    m_module.defineValueStream (target_party_id, andruav_message_id, false, descriptor, window_ms, max_records);
+}
+
+
+bool CFacade_Base::API_pushValues(const uint16_t stream_id, std::initializer_list<double> values) const
+{
+    return m_module.pushValues (stream_id, values.begin(), values.size());
+}
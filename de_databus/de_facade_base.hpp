@@ -2,9 +2,9 @@
 #define P2P_ESP32_FACADE_BASE_H_
 
 #include <iostream>
+#include <initializer_list>
 
-#include "../helpers/json_nlohmann.hpp"
-using Json_de = nlohmann::json;
+#include "../helpers/json_de.hpp"
 
 #include "messages.hpp"
 #include "de_module.hpp"
@@ -30,6 +30,12 @@ namespace de
 
             void API_sendConfigTemplate(const std::string &target_party_id, const std::string &module_key, const Json_de &json_file_content_json, const bool reply);
 
+            /**
+             * @brief declares a value stream. see CModule::defineValueStream
+             */
+            void API_defineValueStream(const std::string &target_party_id, const int andruav_message_id, const CValueStreamDescriptor &descriptor, const uint32_t window_ms, const uint16_t max_records) const;
+            bool API_pushValues(const uint16_t stream_id, std::initializer_list<double> values) const;
+
         protected:
             CModule &m_module = de::comm::CModule::getInstance();
         };
@@ -0,0 +1,90 @@
+#include "messages.hpp"
+#include "de_inbound_message.hpp"
+
+using namespace de::comm;
+
+
+CInboundMessage::CInboundMessage (const char * message, const std::size_t length, CJsonArena * arena, const ENUM_JSON_PARSER parser)
+    : m_message(message), m_length(length), m_arena(arena), m_parser(parser)
+{
+    m_envelope.scan(message, length);
+
+    if (m_arena != nullptr) m_arena->enter();
+}
+
+
+CInboundMessage::~CInboundMessage ()
+{
+    if (m_arena == nullptr) return ;
+
+    // DOMs must be gone before their arena is released.
+    m_json = Json_de();
+    m_cmd = Json_de();
+    m_arena->leave();
+}
+
+
+const Json_de& CInboundMessage::getJson () const
+{
+    if (!m_json_parsed)
+    {
+        CJsonArenaScope arena_scope((m_arena == nullptr) ? nullptr : m_arena->getResource());
+        m_json = parseJson(m_message, m_message + m_envelope.getJsonEnd(), m_parser);
+        m_json_parsed = true;
+        m_json_in_arena = (m_arena != nullptr);
+    }
+
+    return m_json;
+}
+
+
+const Json_de& CInboundMessage::getCmd () const
+{
+    if (m_json_parsed)
+    {
+        const Json_de& json = m_json;
+        if (json.contains(ANDRUAV_PROTOCOL_MESSAGE_CMD)) return json[ANDRUAV_PROTOCOL_MESSAGE_CMD];
+        return m_cmd;
+    }
+
+    if ((!m_cmd_parsed) && (m_envelope.hasCmd()))
+    {
+        CJsonArenaScope arena_scope((m_arena == nullptr) ? nullptr : m_arena->getResource());
+        m_cmd = parseJson(m_message + m_envelope.getCmdBegin(), m_message + m_envelope.getCmdEnd(), m_parser);
+        m_cmd_parsed = true;
+    }
+
+    return m_cmd;
+}
+
+
+void CInboundMessage::assign (const char * message, const std::size_t length, Json_de&& json)
+{
+    m_message = message;
+    m_length = length;
+    m_envelope.scan(message, length);
+
+    m_cmd = Json_de();
+    m_cmd_parsed = false;
+    setJson(std::move(json));
+}
+
+
+Json_de CInboundMessage::takeJson ()
+{
+    CJsonArenaScope heap_scope(std::pmr::new_delete_resource());
+
+    if (!m_json_parsed)
+    {
+        return parseJson(m_message, m_message + m_envelope.getJsonEnd(), m_parser);
+    }
+
+    if (m_json_in_arena)
+    {
+        // the arena DOM stays here and is released with the message.
+        return Json_de(m_json);
+    }
+
+    m_json_parsed = false;
+    return std::move(m_json);
+}
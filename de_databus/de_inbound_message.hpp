@@ -0,0 +1,128 @@
+#ifndef DE_INBOUND_MESSAGE_H_
+#define DE_INBOUND_MESSAGE_H_
+
+#include <cstddef>
+
+#include "../helpers/json_de.hpp"
+
+#include "de_message_envelope.hpp"
+#include "de_json_parser.hpp"
+#include "de_routing_prefix.hpp"
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief a received databus message whose JSON DOM is built on demand.
+     * @details The envelope is scanned in the constructor. getJson() and getCmd()
+     * parse only when a handler asks for them and cache the result,
+     * so messages that are routed or dropped using envelope fields are never parsed.
+     *
+     * The object does not own message buffer and is valid only during the receive callback.
+     * It is not thread safe.
+     *
+     * If an arena is given, DOMs are parsed into it and the arena is released
+     * after the last message using it is destroyed. see @link CJsonArena @endlink
+     * DOMs are built by the given parser backend. see @link parseJson @endlink
+     */
+    class CInboundMessage
+    {
+        public:
+
+            CInboundMessage (const char * message, const std::size_t length, CJsonArena * arena = nullptr,
+                             const ENUM_JSON_PARSER parser = JSON_PARSER_NLOHMANN);
+            ~CInboundMessage ();
+
+            CInboundMessage(CInboundMessage const&)         = delete;
+            void operator=(CInboundMessage const&)          = delete;
+
+        public:
+
+            inline const char * getMessage () const { return m_message; }
+            inline std::size_t getLength () const { return m_length; }
+            inline const CMessageEnvelope& getEnvelope () const { return m_envelope; }
+
+            /**
+             * @brief full message DOM. Parsed on first call.
+             */
+            const Json_de& getJson () const;
+
+            /**
+             * @brief @link ANDRUAV_PROTOCOL_MESSAGE_CMD @endlink section. Only "ms" bytes are parsed
+             * unless the full DOM is already available.
+             */
+            const Json_de& getCmd () const;
+
+            /**
+             * @brief moves full message DOM out of this object.
+             * @details used to feed callbacks that take ownership of the DOM. Such DOMs may
+             * outlive the message, so they are never allocated in the arena: an unparsed message
+             * is parsed on the heap and a DOM already parsed in the arena is copied to the heap.
+             */
+            Json_de takeJson ();
+
+            inline bool isParsed () const { return m_json_parsed; }
+
+            /**
+             * @brief supplies the full DOM when it is already known, e.g. decoded from a binary frame.
+             * @details json must describe the same message as the text and be allocated outside the arena.
+             */
+            inline void setJson (Json_de&& json)
+            {
+                m_json = std::move(json);
+                m_json_parsed = true;
+                m_json_in_arena = false;
+            }
+
+            /**
+             * @brief replaces the message with a rebuilt one, e.g. a delta encoded message made complete.
+             * @details envelope is scanned again and json is the DOM of the new message.
+             * The new buffer must outlive this object.
+             */
+            void assign (const char * message, const std::size_t length, Json_de&& json);
+
+            /**
+             * @brief routing prefix the message arrived with. see @link ROUTING_PREFIX @endlink
+             */
+            inline bool hasRoutingPrefix () const { return m_has_routing_prefix; }
+            inline const ROUTING_PREFIX& getRoutingPrefix () const { return m_routing_prefix; }
+
+            inline void setRoutingPrefix (const ROUTING_PREFIX& prefix)
+            {
+                m_routing_prefix = prefix;
+                m_has_routing_prefix = true;
+            }
+
+            inline bool isBinary () const { return m_envelope.isBinary(); }
+
+            /**
+             * @brief binary part of a message sent by @link CModule::sendBMSG @endlink.
+             * @details O(1). Offsets are recorded while scanning the envelope. Empty for text messages.
+             */
+            inline CByteSpan getBinaryPayload () const
+            {
+                return CByteSpan(m_message + m_envelope.getBinaryBegin(), m_envelope.getBinaryEnd() - m_envelope.getBinaryBegin());
+            }
+
+        private:
+
+            const char * m_message;
+            std::size_t m_length;
+            CMessageEnvelope m_envelope;
+            CJsonArena * m_arena;
+            const ENUM_JSON_PARSER m_parser;
+
+            bool m_has_routing_prefix = false;
+            ROUTING_PREFIX m_routing_prefix = {};
+
+            mutable bool m_json_parsed = false;
+            mutable bool m_json_in_arena = false;
+            mutable bool m_cmd_parsed = false;
+            mutable Json_de m_json;
+            mutable Json_de m_cmd;
+    };
+}
+}
+
+#endif
@@ -0,0 +1,698 @@
+#include <cerrno>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <charconv>
+#include <atomic>
+#include <string>
+#include <string_view>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "de_json_parser.hpp"
+
+using namespace de::comm;
+
+
+static std::atomic<uint64_t> s_fallback_count(0);
+
+
+/**
+ * @brief reads a number that passed the JSON grammar check as double.
+ * @details std::from_chars for double needs GCC 11 (libstdc++ 11). Older compilers, such as the
+ * default one of older Raspberry Pi OS releases, use strtod with the decimal point of the current
+ * locale as nlohmann lexer does.
+ * @return false if out of double range. Such numbers are left to nlohmann.
+ */
+static bool readDouble (const char * first, const char * last, double& value)
+{
+#if defined(__cpp_lib_to_chars)
+    const std::from_chars_result result = std::from_chars(first, last, value);
+    return result.ec == std::errc();
+#else
+    char buffer[128];
+    const std::size_t length = last - first;
+    if (length >= sizeof(buffer)) return false;
+
+    std::memcpy(buffer, first, length);
+    buffer[length] = 0;
+    const char decimal_point = *std::localeconv()->decimal_point;
+    if (decimal_point != '.')
+    {
+        char * dot = static_cast<char *>(std::memchr(buffer, '.', length));
+        if (dot != nullptr) *dot = decimal_point;
+    }
+
+    errno = 0;
+    char * end = nullptr;
+    value = std::strtod(buffer, &end);
+    return (errno != ERANGE) && (end == buffer + length);
+#endif
+}
+
+
+/**
+ * @brief bit masks of one 64 byte block. Bit i refers to byte i.
+ */
+typedef struct
+{
+    uint64_t quote;
+    uint64_t backslash;
+    // { } [ ] : ,
+    uint64_t op;
+} JSON_BLOCK_MASKS;
+
+
+#if defined(__AVX2__)
+
+static inline uint64_t compareMask (const __m256i lo, const __m256i hi, const char c)
+{
+    const __m256i v = _mm256_set1_epi8(c);
+    const uint64_t l = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, v)));
+    const uint64_t h = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, v)));
+    return l | (h << 32);
+}
+
+static inline void classifyBlock (const char * block, JSON_BLOCK_MASKS& masks)
+{
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+
+    masks.quote = compareMask(lo, hi, '"');
+    masks.backslash = compareMask(lo, hi, '\\');
+    masks.op = compareMask(lo, hi, '{') | compareMask(lo, hi, '}')
+             | compareMask(lo, hi, '[') | compareMask(lo, hi, ']')
+             | compareMask(lo, hi, ':') | compareMask(lo, hi, ',');
+}
+
+#define JSON_SCANNER_NAME   "avx2"
+
+#elif defined(__SSE2__)
+
+static inline uint64_t compareMask (const __m128i (&chunks)[4], const char c)
+{
+    const __m128i v = _mm_set1_epi8(c);
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], v)))) << (i * 16);
+    }
+    return mask;
+}
+
+static inline void classifyBlock (const char * block, JSON_BLOCK_MASKS& masks)
+{
+    const __m128i chunks[4] = {
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(block)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 32)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 48))
+    };
+
+    masks.quote = compareMask(chunks, '"');
+    masks.backslash = compareMask(chunks, '\\');
+    masks.op = compareMask(chunks, '{') | compareMask(chunks, '}')
+             | compareMask(chunks, '[') | compareMask(chunks, ']')
+             | compareMask(chunks, ':') | compareMask(chunks, ',');
+}
+
+#define JSON_SCANNER_NAME   "sse2"
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+/**
+ * @brief NEON has no movemask. Each lane keeps one weight bit and pairwise
+ * additions fold 64 lanes into 64 bits.
+ */
+static inline uint64_t movemask (const uint8x16_t m0, const uint8x16_t m1, const uint8x16_t m2, const uint8x16_t m3)
+{
+    static const uint8_t weights[16] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+                                        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+    const uint8x16_t w = vld1q_u8(weights);
+    uint8x16_t s0 = vpaddq_u8(vandq_u8(m0, w), vandq_u8(m1, w));
+    uint8x16_t s1 = vpaddq_u8(vandq_u8(m2, w), vandq_u8(m3, w));
+    s0 = vpaddq_u8(s0, s1);
+    s0 = vpaddq_u8(s0, s0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+}
+
+static inline uint64_t compareMask (const uint8x16_t (&chunks)[4], const char c)
+{
+    const uint8x16_t v = vdupq_n_u8(static_cast<uint8_t>(c));
+    return movemask(vceqq_u8(chunks[0], v), vceqq_u8(chunks[1], v), vceqq_u8(chunks[2], v), vceqq_u8(chunks[3], v));
+}
+
+static inline void classifyBlock (const char * block, JSON_BLOCK_MASKS& masks)
+{
+    const uint8_t * p = reinterpret_cast<const uint8_t *>(block);
+    const uint8x16_t chunks[4] = { vld1q_u8(p), vld1q_u8(p + 16), vld1q_u8(p + 32), vld1q_u8(p + 48) };
+
+    masks.quote = compareMask(chunks, '"');
+    masks.backslash = compareMask(chunks, '\\');
+    masks.op = compareMask(chunks, '{') | compareMask(chunks, '}')
+             | compareMask(chunks, '[') | compareMask(chunks, ']')
+             | compareMask(chunks, ':') | compareMask(chunks, ',');
+}
+
+#define JSON_SCANNER_NAME   "neon"
+
+#else
+
+static inline void classifyBlock (const char * block, JSON_BLOCK_MASKS& masks)
+{
+    masks.quote = 0;
+    masks.backslash = 0;
+    masks.op = 0;
+    for (int i = 0; i < 64; ++i)
+    {
+        const uint64_t bit = static_cast<uint64_t>(1) << i;
+        switch (block[i])
+        {
+            case '"':   masks.quote |= bit; break;
+            case '\\':  masks.backslash |= bit; break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':   masks.op |= bit; break;
+        }
+    }
+}
+
+#define JSON_SCANNER_NAME   "scalar"
+
+#endif
+
+
+/**
+ * @brief bit i of result is the XOR of bits 0..i. Turns quote bits into in-string bits.
+ */
+static inline uint64_t prefixXor (uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+
+/**
+ * @brief characters escaped by a backslash.
+ * @details a character is escaped when an odd run of backslashes ends just before it.
+ * Adding run start bits to the backslash mask makes the carry run to the end of each
+ * run, so the parity of a run shows up as whether its end lands on an odd or even bit.
+ * @param prev_escaped in: first byte of this block is escaped. out: same for the next block.
+ */
+static inline uint64_t findEscaped (uint64_t backslash, uint64_t& prev_escaped)
+{
+    static const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+    backslash &= ~prev_escaped;
+    const uint64_t follows_escape = (backslash << 1) | prev_escaped;
+    const uint64_t odd_sequence_starts = backslash & ~EVEN_BITS & ~follows_escape;
+
+    uint64_t sequences_starting_on_even_bits;
+    prev_escaped = __builtin_add_overflow(odd_sequence_starts, backslash, &sequences_starting_on_even_bits) ? 1 : 0;
+
+    const uint64_t invert_mask = sequences_starting_on_even_bits << 1;
+    return (EVEN_BITS ^ invert_mask) & follows_escape;
+}
+
+
+bool CJsonStructuralIndex::build (const char * text, const std::size_t length)
+{
+    m_positions.clear();
+    // protocol messages have roughly one structural every 6 bytes.
+    if (m_positions.capacity() < length / 4) m_positions.reserve(length / 4);
+
+    uint64_t prev_escaped = 0;
+    uint64_t prev_in_string = 0;
+    JSON_BLOCK_MASKS masks;
+    // last partial block is padded with spaces.
+    char tail[64];
+
+    for (std::size_t base = 0; base < length; base += 64)
+    {
+        const char * block = text + base;
+        if (length - base < 64)
+        {
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, length - base);
+            block = tail;
+        }
+
+        classifyBlock(block, masks);
+
+        const uint64_t escaped = findEscaped(masks.backslash, prev_escaped);
+        const uint64_t quote = masks.quote & ~escaped;
+        const uint64_t in_string = prefixXor(quote) ^ prev_in_string;
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+        uint64_t structurals = (masks.op & ~in_string) | quote;
+        while (structurals != 0)
+        {
+            m_positions.push_back(static_cast<uint32_t>(base + __builtin_ctzll(structurals)));
+            structurals &= structurals - 1;
+        }
+    }
+
+    return prev_in_string == 0;
+}
+
+
+const char * CJsonStructuralIndex::getImplementationName ()
+{
+    return JSON_SCANNER_NAME;
+}
+
+
+
+namespace
+{
+    static inline bool isJsonWhiteSpace (const char c)
+    {
+        return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+    }
+
+
+    static inline int hexValue (const char c)
+    {
+        if ((c >= '0') && (c <= '9')) return c - '0';
+        if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+        if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+        return -1;
+    }
+
+
+    static inline void appendUtf8 (std::string& out, const uint32_t code_point)
+    {
+        if (code_point < 0x80)
+        {
+            out.push_back(static_cast<char>(code_point));
+        }
+        else if (code_point < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+        else if (code_point < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+    }
+
+
+    /**
+     * @brief builds Json_de from a structural index.
+     * @details every function returns false on anything that is not plain valid JSON.
+     * The caller then parses the text again with nlohmann, which produces the exact result or error.
+     */
+    class CJsonMaterializer
+    {
+        public:
+
+            CJsonMaterializer (const char * text, const std::size_t length, const std::vector<uint32_t>& positions)
+                : m_text(text), m_length(length), m_positions(positions.data()), m_count(positions.size())
+            {
+            }
+
+            bool parseDocument (Json_de& out)
+            {
+                std::size_t end;
+                if (!parseValue(0, out, 0, end)) return false;
+
+                // only white space may follow the root value.
+                return (m_index == m_count) && isWhiteSpaceOnly(end, m_length);
+            }
+
+        private:
+
+            inline std::size_t nextPosition () const
+            {
+                return (m_index < m_count) ? m_positions[m_index] : m_length;
+            }
+
+            inline bool isWhiteSpaceOnly (std::size_t begin, const std::size_t end) const
+            {
+                for (; begin < end; ++begin)
+                {
+                    if (!isJsonWhiteSpace(m_text[begin])) return false;
+                }
+                return true;
+            }
+
+            /**
+             * @param begin first byte after the previous structural.
+             * @param end out: first byte after the value.
+             */
+            bool parseValue (const std::size_t begin, Json_de& out, const int depth, std::size_t& end)
+            {
+                // scalars have no structural of their own. They are whatever sits in the gap.
+                const std::size_t next = nextPosition();
+                std::size_t first = begin;
+                while ((first < next) && isJsonWhiteSpace(m_text[first])) ++first;
+                if (first < next)
+                {
+                    std::size_t last = next;
+                    while (isJsonWhiteSpace(m_text[last - 1])) --last;
+                    end = next;
+                    return parseScalar(std::string_view(m_text + first, last - first), out);
+                }
+
+                if (m_index >= m_count) return false;
+                if (depth >= JSON_STRUCTURAL_MAX_DEPTH) return false;
+
+                switch (m_text[next])
+                {
+                    case '"':
+                        {
+                            out = Json_de::string_t();
+                            if (!parseString(out.get_ref<Json_de::string_t&>())) return false;
+                            end = m_positions[m_index - 1] + 1;
+                            return true;
+                        }
+                    case '{':
+                        return parseObject(out, depth, end);
+                    case '[':
+                        return parseArray(out, depth, end);
+                    default:
+                        return false;
+                }
+            }
+
+            bool parseObject (Json_de& out, const int depth, std::size_t& end)
+            {
+                out = Json_de::object();
+                std::size_t after = m_positions[m_index++] + 1;
+
+                if ((m_index < m_count) && (m_text[m_positions[m_index]] == '}') && isWhiteSpaceOnly(after, m_positions[m_index]))
+                {
+                    end = m_positions[m_index++] + 1;
+                    return true;
+                }
+
+                std::string key;
+                while (true)
+                {
+                    if ((m_index >= m_count) || (m_text[m_positions[m_index]] != '"')) return false;
+                    if (!isWhiteSpaceOnly(after, m_positions[m_index])) return false;
+
+                    key.clear();
+                    if (!parseString(key)) return false;
+                    after = m_positions[m_index - 1] + 1;
+
+                    if ((m_index >= m_count) || (m_text[m_positions[m_index]] != ':')) return false;
+                    if (!isWhiteSpaceOnly(after, m_positions[m_index])) return false;
+                    after = m_positions[m_index++] + 1;
+
+                    // duplicate keys: last one wins as in nlohmann.
+                    if (!parseValue(after, out[key], depth + 1, after)) return false;
+
+                    if (m_index >= m_count) return false;
+                    if (!isWhiteSpaceOnly(after, m_positions[m_index])) return false;
+
+                    const char c = m_text[m_positions[m_index]];
+                    after = m_positions[m_index++] + 1;
+                    if (c == '}')
+                    {
+                        end = after;
+                        return true;
+                    }
+                    if (c != ',') return false;
+                }
+            }
+
+            bool parseArray (Json_de& out, const int depth, std::size_t& end)
+            {
+                out = Json_de::array();
+                std::size_t after = m_positions[m_index++] + 1;
+
+                if ((m_index < m_count) && (m_text[m_positions[m_index]] == ']') && isWhiteSpaceOnly(after, m_positions[m_index]))
+                {
+                    end = m_positions[m_index++] + 1;
+                    return true;
+                }
+
+                Json_de::array_t& array = out.get_ref<Json_de::array_t&>();
+                while (true)
+                {
+                    array.emplace_back();
+                    if (!parseValue(after, array.back(), depth + 1, after)) return false;
+
+                    if (m_index >= m_count) return false;
+                    if (!isWhiteSpaceOnly(after, m_positions[m_index])) return false;
+
+                    const char c = m_text[m_positions[m_index]];
+                    after = m_positions[m_index++] + 1;
+                    if (c == ']')
+                    {
+                        end = after;
+                        return true;
+                    }
+                    if (c != ',') return false;
+                }
+            }
+
+            /**
+             * @brief decodes string whose opening quote is the current structural.
+             */
+            bool parseString (std::string& out)
+            {
+                if (m_index + 1 >= m_count) return false;
+
+                const char * p = m_text + m_positions[m_index] + 1;
+                const char * const last = m_text + m_positions[m_index + 1];
+                m_index += 2;
+
+                // common case: printable ASCII without escapes is copied as is.
+                const char * run = p;
+                while (p < last)
+                {
+                    const unsigned char c = static_cast<unsigned char>(*p);
+                    if ((c >= 0x20) && (c < 0x80) && (c != '\\'))
+                    {
+                        ++p;
+                        continue;
+                    }
+
+                    out.append(run, p - run);
+
+                    if (c == '\\')
+                    {
+                        if (!parseEscape(p, last, out)) return false;
+                    }
+                    else if (c < 0x20)
+                    {
+                        return false;
+                    }
+                    else
+                    {
+                        const std::size_t n = getUtf8SequenceLength(reinterpret_cast<const unsigned char *>(p), reinterpret_cast<const unsigned char *>(last));
+                        if (n == 0) return false;
+                        out.append(p, n);
+                        p += n;
+                    }
+                    run = p;
+                }
+
+                out.append(run, p - run);
+                return true;
+            }
+
+            static bool readHex4 (const char * p, const char * last, uint32_t& value)
+            {
+                if (last - p < 4) return false;
+                value = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    const int h = hexValue(p[i]);
+                    if (h < 0) return false;
+                    value = (value << 4) | static_cast<uint32_t>(h);
+                }
+                return true;
+            }
+
+            /**
+             * @param p in: position of the back slash. out: first byte after the escape.
+             */
+            static bool parseEscape (const char *& p, const char * last, std::string& out)
+            {
+                if (last - p < 2) return false;
+
+                switch (p[1])
+                {
+                    case '"':   out.push_back('"');  p += 2; return true;
+                    case '\\':  out.push_back('\\'); p += 2; return true;
+                    case '/':   out.push_back('/');  p += 2; return true;
+                    case 'b':   out.push_back('\b'); p += 2; return true;
+                    case 'f':   out.push_back('\f'); p += 2; return true;
+                    case 'n':   out.push_back('\n'); p += 2; return true;
+                    case 'r':   out.push_back('\r'); p += 2; return true;
+                    case 't':   out.push_back('\t'); p += 2; return true;
+                    case 'u':   break;
+                    default:    return false;
+                }
+
+                uint32_t code_point;
+                if (!readHex4(p + 2, last, code_point)) return false;
+                p += 6;
+
+                if ((code_point >= 0xDC00) && (code_point <= 0xDFFF)) return false;
+
+                if ((code_point >= 0xD800) && (code_point <= 0xDBFF))
+                {
+                    // high surrogate must be followed by an escaped low surrogate.
+                    uint32_t low;
+                    if ((last - p < 2) || (p[0] != '\\') || (p[1] != 'u')) return false;
+                    if (!readHex4(p + 2, last, low)) return false;
+                    if ((low < 0xDC00) || (low > 0xDFFF)) return false;
+                    p += 6;
+
+                    code_point = 0x10000 + (((code_point - 0xD800) << 10) | (low - 0xDC00));
+                }
+
+                appendUtf8(out, code_point);
+                return true;
+            }
+
+            /**
+             * @brief true, false, null or a number with the value types nlohmann chooses:
+             * unsigned for non negative integers, signed for negative ones and
+             * double for fractions, exponents and integers that overflow 64 bits.
+             */
+            static bool parseScalar (const std::string_view text, Json_de& out)
+            {
+                if (text == "true")  { out = true; return true; }
+                if (text == "false") { out = false; return true; }
+                if (text == "null")  { out = nullptr; return true; }
+
+                // JSON number grammar. from_chars alone accepts things like leading zeros.
+                const char * p = text.data();
+                const char * const last = p + text.size();
+                bool is_integer = true;
+
+                if ((p < last) && (*p == '-')) ++p;
+                if (p == last) return false;
+                if (*p == '0')
+                {
+                    ++p;
+                }
+                else if ((*p >= '1') && (*p <= '9'))
+                {
+                    while ((p < last) && (*p >= '0') && (*p <= '9')) ++p;
+                }
+                else
+                {
+                    return false;
+                }
+
+                if ((p < last) && (*p == '.'))
+                {
+                    is_integer = false;
+                    ++p;
+                    if ((p == last) || (*p < '0') || (*p > '9')) return false;
+                    while ((p < last) && (*p >= '0') && (*p <= '9')) ++p;
+                }
+
+                if ((p < last) && ((*p == 'e') || (*p == 'E')))
+                {
+                    is_integer = false;
+                    ++p;
+                    if ((p < last) && ((*p == '+') || (*p == '-'))) ++p;
+                    if ((p == last) || (*p < '0') || (*p > '9')) return false;
+                    while ((p < last) && (*p >= '0') && (*p <= '9')) ++p;
+                }
+
+                if (p != last) return false;
+
+                const char * const first = text.data();
+                if (is_integer)
+                {
+                    if (*first == '-')
+                    {
+                        int64_t value;
+                        const std::from_chars_result result = std::from_chars(first, last, value);
+                        if (result.ec == std::errc())
+                        {
+                            out = value;
+                            return true;
+                        }
+                    }
+                    else
+                    {
+                        uint64_t value;
+                        const std::from_chars_result result = std::from_chars(first, last, value);
+                        if (result.ec == std::errc())
+                        {
+                            out = value;
+                            return true;
+                        }
+                    }
+                }
+
+                // out of range (overflow or underflow) is left to nlohmann.
+                double value;
+                if (!readDouble(first, last, value)) return false;
+
+                out = value;
+                return true;
+            }
+
+        private:
+
+            const char * m_text;
+            const std::size_t m_length;
+            const uint32_t * m_positions;
+            const std::size_t m_count;
+            std::size_t m_index = 0;
+    };
+}
+
+
+
+Json_de de::comm::parseJson (const char * first, const char * last, const ENUM_JSON_PARSER parser)
+{
+    if (parser == JSON_PARSER_STRUCTURAL)
+    {
+        // index positions are 32 bit.
+        const std::size_t length = last - first;
+        if (length <= UINT32_MAX)
+        {
+            static thread_local CJsonStructuralIndex index;
+
+            if (index.build(first, length))
+            {
+                Json_de json;
+                CJsonMaterializer materializer(first, length, index.getPositions());
+                if (materializer.parseDocument(json)) return json;
+            }
+        }
+
+        s_fallback_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return Json_de::parse(first, last);
+}
+
+
+uint64_t de::comm::getJsonParserFallbackCount ()
+{
+    return s_fallback_count.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,108 @@
+#ifndef DE_JSON_PARSER_H_
+#define DE_JSON_PARSER_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "../helpers/json_de.hpp"
+
+
+typedef enum {
+    // nlohmann recursive descent parser.
+    JSON_PARSER_NLOHMANN        = 0,
+    // vectorized structural scanner then DOM materializer. see CJsonStructuralIndex
+    JSON_PARSER_STRUCTURAL      = 1
+} ENUM_JSON_PARSER;
+
+
+// deeper documents are handed to nlohmann parser.
+#define JSON_STRUCTURAL_MAX_DEPTH       256
+
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief positions of JSON structural characters.
+     * @details text is classified 64 bytes at a time using SSE2/AVX2 on x86 or NEON on ARM
+     * (scalar code elsewhere). Escaped quotes are resolved with carry propagation over
+     * backslash runs and string interiors with a prefix XOR of quote bits, so no
+     * per-byte state machine is needed.
+     * Recorded positions are every unescaped quote plus { } [ ] : , outside strings.
+     * Scalars (numbers, true, false, null) are the text between structurals.
+     */
+    class CJsonStructuralIndex
+    {
+        public:
+
+            /**
+             * @return false if a string is not terminated.
+             */
+            bool build (const char * text, const std::size_t length);
+
+            inline const std::vector<uint32_t>& getPositions () const { return m_positions; }
+
+            /**
+             * @brief instruction set used by build(). "avx2", "sse2", "neon" or "scalar".
+             */
+            static const char * getImplementationName ();
+
+        private:
+
+            std::vector<uint32_t> m_positions;
+    };
+
+
+    /**
+     * @brief parses [first, last) using the selected backend.
+     * @details JSON_PARSER_STRUCTURAL materializes the DOM from the structural index.
+     * Any input it does not fully validate itself (syntax errors, invalid UTF-8,
+     * numbers out of double range, very deep nesting) is parsed again by nlohmann,
+     * so results and thrown exceptions are always those of Json_de::parse.
+     */
+    Json_de parseJson (const char * first, const char * last, const ENUM_JSON_PARSER parser);
+
+    /**
+     * @brief number of JSON_PARSER_STRUCTURAL parses that were handed to nlohmann.
+     */
+    uint64_t getJsonParserFallbackCount ();
+
+
+    /**
+     * @brief length of a well formed UTF-8 sequence starting at p, 0 if ill formed.
+     * @details same ranges as RFC 3629 table that nlohmann enforces when parsing and dumping.
+     */
+    inline std::size_t getUtf8SequenceLength (const unsigned char * p, const unsigned char * end)
+    {
+        const unsigned char c = p[0];
+        const std::ptrdiff_t left = end - p;
+
+        auto continuation = [&](const std::ptrdiff_t i, const unsigned char low, const unsigned char high)
+        {
+            return (i < left) && (p[i] >= low) && (p[i] <= high);
+        };
+
+        if ((c >= 0xC2) && (c <= 0xDF))
+        {
+            return continuation(1, 0x80, 0xBF) ? 2 : 0;
+        }
+        if ((c >= 0xE0) && (c <= 0xEF))
+        {
+            const unsigned char low = (c == 0xE0) ? 0xA0 : 0x80;
+            const unsigned char high = (c == 0xED) ? 0x9F : 0xBF;
+            return (continuation(1, low, high) && continuation(2, 0x80, 0xBF)) ? 3 : 0;
+        }
+        if ((c >= 0xF0) && (c <= 0xF4))
+        {
+            const unsigned char low = (c == 0xF0) ? 0x90 : 0x80;
+            const unsigned char high = (c == 0xF4) ? 0x8F : 0xBF;
+            return (continuation(1, low, high) && continuation(2, 0x80, 0xBF) && continuation(3, 0x80, 0xBF)) ? 4 : 0;
+        }
+        return 0;
+    }
+}
+}
+
+#endif
@@ -0,0 +1,333 @@
+#include <cmath>
+#include <clocale>
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "de_json_parser.hpp"
+#include "de_json_writer.hpp"
+
+using namespace de::comm;
+
+
+// doubles are written in plain notation when their decimal exponent is within these limits. see nlohmann::detail::dtoa_impl::format_buffer
+#define JSON_FLOAT_MIN_EXPONENT     -4
+#define JSON_FLOAT_MAX_EXPONENT     15
+
+
+static inline bool needsEscape (const unsigned char c)
+{
+    return (c < 0x20) || (c >= 0x80) || (c == '"') || (c == '\\');
+}
+
+
+/**
+ * @brief first byte in [p, end) that is a control character, quote, back slash or non ASCII.
+ */
+static inline const char * findEscapeCandidate (const char * p, const char * end)
+{
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    for (; end - p >= 16; p += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        // signed compare: bytes >= 0x80 are negative so they are caught with control characters.
+        const __m128i m = _mm_or_si128(_mm_cmplt_epi8(v, space),
+                          _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+        const int mask = _mm_movemask_epi8(m);
+        if (mask != 0) return p + __builtin_ctz(mask);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    const uint8x16_t high = vdupq_n_u8(0x80);
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    for (; end - p >= 16; p += 16)
+    {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p));
+        const uint8x16_t m = vorrq_u8(vorrq_u8(vcltq_u8(v, space), vcgeq_u8(v, high)),
+                                      vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, backslash)));
+        if (vmaxvq_u8(m) != 0) break;
+    }
+#endif
+
+    while ((p < end) && !needsEscape(static_cast<unsigned char>(*p))) ++p;
+    return p;
+}
+
+
+void de::comm::appendJsonString (std::string& out, const std::string_view value)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+
+    const std::size_t start_length = out.length();
+    out.push_back('"');
+
+    const char * p = value.data();
+    const char * const end = p + value.size();
+    while (p < end)
+    {
+        const char * run_end = findEscapeCandidate(p, end);
+        out.append(p, run_end - p);
+        p = run_end;
+        if (p == end) break;
+
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c >= 0x80)
+        {
+            const std::size_t n = getUtf8SequenceLength(reinterpret_cast<const unsigned char *>(p), reinterpret_cast<const unsigned char *>(end));
+            if (n == 0)
+            {
+                // let nlohmann report the error exactly as Json_de::dump() does.
+                out.resize(start_length);
+                out += Json_de(std::string(value)).dump();
+                return ;
+            }
+            out.append(p, n);
+            p += n;
+            continue;
+        }
+
+        switch (c)
+        {
+            case '"':   out += "\\\""; break;
+            case '\\':  out += "\\\\"; break;
+            case '\b':  out += "\\b"; break;
+            case '\f':  out += "\\f"; break;
+            case '\n':  out += "\\n"; break;
+            case '\r':  out += "\\r"; break;
+            case '\t':  out += "\\t"; break;
+            default:
+                {
+                    const char escape[6] = {'\\', 'u', '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0x0F]};
+                    out.append(escape, sizeof(escape));
+                }
+                break;
+        }
+        ++p;
+    }
+
+    out.push_back('"');
+}
+
+
+#if defined(__cpp_lib_to_chars)
+/**
+ * @brief lays out decimal digits of a value = 0.digits * 10^point the way nlohmann does.
+ */
+static void appendDecimal (std::string& out, const char * digits, const int count, const int point)
+{
+    if ((count <= point) && (point <= JSON_FLOAT_MAX_EXPONENT))
+    {
+        // 1234e7 -> 12340000000.0
+        out.append(digits, count);
+        out.append(point - count, '0');
+        out += ".0";
+    }
+    else if ((0 < point) && (point <= JSON_FLOAT_MAX_EXPONENT))
+    {
+        // 1234e-2 -> 12.34
+        out.append(digits, point);
+        out.push_back('.');
+        out.append(digits + point, count - point);
+    }
+    else if ((JSON_FLOAT_MIN_EXPONENT < point) && (point <= 0))
+    {
+        // 1234e-6 -> 0.001234
+        out += "0.";
+        out.append(-point, '0');
+        out.append(digits, count);
+    }
+    else
+    {
+        // 1234e30 -> 1.234e+33
+        out.push_back(digits[0]);
+        if (count > 1)
+        {
+            out.push_back('.');
+            out.append(digits + 1, count - 1);
+        }
+
+        int exponent = point - 1;
+        out.push_back('e');
+        out.push_back((exponent < 0) ? '-' : '+');
+        if (exponent < 0) exponent = -exponent;
+        if (exponent >= 100) out.push_back(static_cast<char>('0' + exponent / 100));
+        out.push_back(static_cast<char>('0' + (exponent / 10) % 10));
+        out.push_back(static_cast<char>('0' + exponent % 10));
+    }
+}
+#endif
+
+
+void de::comm::appendJsonNumber (std::string& out, double value, const int decimal_places)
+{
+    if (!std::isfinite(value))
+    {
+        out += "null";
+        return ;
+    }
+
+    if (std::signbit(value))
+    {
+        out.push_back('-');
+        value = -value;
+    }
+
+    if (value == 0)
+    {
+        out += "0.0";
+        return ;
+    }
+
+    char buffer[64];
+
+    // capped values are rounded in decimal. Large values would need many digits so they stay shortest.
+    if ((decimal_places >= 0) && (decimal_places <= 17) && (value < 1e15))
+    {
+#if defined(__cpp_lib_to_chars)
+        const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, decimal_places);
+        const char * last = result.ptr;
+#else
+        // std::to_chars for double needs GCC 11. snprintf uses the decimal point of the current locale.
+        const char * last = buffer + std::snprintf(buffer, sizeof(buffer), "%.*f", decimal_places, value);
+        const char decimal_point = *std::localeconv()->decimal_point;
+        char * dot = static_cast<char *>(std::memchr(buffer, decimal_point, last - buffer));
+        if (dot != nullptr) *dot = '.';
+#endif
+        if (decimal_places > 0)
+        {
+            while (last[-1] == '0') --last;
+            if (last[-1] == '.') --last;
+        }
+
+        out.append(buffer, last - buffer);
+        // keep the value a float for the receiver.
+        if (std::memchr(buffer, '.', last - buffer) == nullptr) out += ".0";
+        return ;
+    }
+
+#if defined(__cpp_lib_to_chars)
+    // shortest round trip digits as d.ddde[+-]x
+    const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::scientific);
+    const char * exponent_mark = static_cast<const char *>(std::memchr(buffer, 'e', result.ptr - buffer));
+
+    int exponent = 0;
+    std::from_chars((exponent_mark[1] == '+') ? exponent_mark + 2 : exponent_mark + 1, result.ptr, exponent);
+
+    char digits[24];
+    int count = 0;
+    for (const char * p = buffer; p < exponent_mark; ++p)
+    {
+        if (*p != '.') digits[count++] = *p;
+    }
+
+    appendDecimal(out, digits, count, exponent + 1);
+#else
+    // nlohmann writes the same layout. Its digits round trip but are sometimes one longer than shortest.
+    out += Json_de(value).dump();
+#endif
+}
+
+
+static void appendValue (std::string& out, const Json_de& value, const JSON_FIELD_PRECISION * precision)
+{
+    char number[24];
+
+    switch (value.type())
+    {
+        case Json_de::value_t::object:
+            {
+                const Json_de::object_t& object = value.get_ref<const Json_de::object_t&>();
+                out.push_back('{');
+                bool first = true;
+                for (const auto& member : object)
+                {
+                    if (!first) out.push_back(',');
+                    first = false;
+
+                    appendJsonString(out, member.first);
+                    out.push_back(':');
+
+                    if ((precision != nullptr) && member.second.is_number_float())
+                    {
+                        const JSON_FIELD_PRECISION::const_iterator cap = precision->find(member.first);
+                        if (cap != precision->end())
+                        {
+                            appendJsonNumber(out, member.second.get<double>(), cap->second);
+                            continue;
+                        }
+                    }
+
+                    // caps apply to top level members only.
+                    appendValue(out, member.second, nullptr);
+                }
+                out.push_back('}');
+            }
+            break;
+
+        case Json_de::value_t::array:
+            {
+                const Json_de::array_t& array = value.get_ref<const Json_de::array_t&>();
+                out.push_back('[');
+                bool first = true;
+                for (const Json_de& element : array)
+                {
+                    if (!first) out.push_back(',');
+                    first = false;
+                    appendValue(out, element, nullptr);
+                }
+                out.push_back(']');
+            }
+            break;
+
+        case Json_de::value_t::string:
+            appendJsonString(out, value.get_ref<const Json_de::string_t&>());
+            break;
+
+        case Json_de::value_t::boolean:
+            out += value.get<bool>() ? "true" : "false";
+            break;
+
+        case Json_de::value_t::number_integer:
+            {
+                const std::to_chars_result result = std::to_chars(number, number + sizeof(number), value.get<Json_de::number_integer_t>());
+                out.append(number, result.ptr - number);
+            }
+            break;
+
+        case Json_de::value_t::number_unsigned:
+            {
+                const std::to_chars_result result = std::to_chars(number, number + sizeof(number), value.get<Json_de::number_unsigned_t>());
+                out.append(number, result.ptr - number);
+            }
+            break;
+
+        case Json_de::value_t::number_float:
+            appendJsonNumber(out, value.get<double>());
+            break;
+
+        case Json_de::value_t::null:
+            out += "null";
+            break;
+
+        default:
+            // binary and discarded values never appear in messages.
+            out += value.dump();
+            break;
+    }
+}
+
+
+void de::comm::appendJson (std::string& out, const Json_de& value, const JSON_FIELD_PRECISION * precision)
+{
+    appendValue(out, value, precision);
+}
@@ -0,0 +1,51 @@
+#ifndef DE_JSON_WRITER_H_
+#define DE_JSON_WRITER_H_
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <functional>
+
+#include "../helpers/json_de.hpp"
+
+
+/**
+ * @brief decimal places kept for floating point members, by member key.
+ */
+typedef std::map<std::string, int, std::less<>> JSON_FIELD_PRECISION;
+
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief appends JSON text of value to out. Output is that of Json_de::dump().
+     * @details objects, arrays and scalars are written directly into out:
+     *  - doubles use shortest round trip digits of std::to_chars laid out as nlohmann does,
+     *    so integral doubles keep ".0" and remain floats for the receiver.
+     *  - strings are scanned 16 bytes at a time (SSE2 / NEON) for bytes that need escaping
+     *    and plain runs are copied in one step.
+     * Invalid UTF-8 throws the same type_error as Json_de::dump().
+     *
+     * @param precision optional decimal places for floating point members of the top level object.
+     * Values are rounded to nearest and trailing zeros are dropped. 7 places on latitude keeps
+     * about 1cm, 2 places on a voltage keeps 10mV.
+     */
+    void appendJson (std::string& out, const Json_de& value, const JSON_FIELD_PRECISION * precision = nullptr);
+
+    /**
+     * @brief appends value as a quoted and escaped JSON string.
+     */
+    void appendJsonString (std::string& out, const std::string_view value);
+
+    /**
+     * @brief appends a floating point number.
+     * @param decimal_places negative for shortest round trip representation.
+     * non finite values are written as null.
+     */
+    void appendJsonNumber (std::string& out, const double value, const int decimal_places = -1);
+}
+}
+
+#endif
@@ -0,0 +1,237 @@
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <cmath>
+
+#include "messages.hpp"
+#include "de_message_envelope.hpp"
+
+using namespace de::comm;
+
+
+static inline bool isJsonWhiteSpace (const char c)
+{
+    return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+}
+
+
+static inline std::size_t skipWhiteSpace (const char * message, std::size_t pos, const std::size_t length)
+{
+    while ((pos < length) && isJsonWhiteSpace(message[pos])) ++pos;
+    return pos;
+}
+
+
+/**
+ * @brief skips a JSON string.
+ * @param pos position of the opening quote.
+ * @return position after the closing quote or 0 if string is not terminated.
+ */
+static std::size_t skipString (const char * message, std::size_t pos, const std::size_t length)
+{
+    ++pos;
+    while (pos < length)
+    {
+        const char * quote = static_cast<const char *>(std::memchr(message + pos, '"', length - pos));
+        if (quote == nullptr) return 0;
+
+        std::size_t end = quote - message;
+
+        // count back slashes before quote. odd count means quote is escaped.
+        std::size_t slashes = 0;
+        while ((end - slashes > pos) && (message[end - slashes - 1] == '\\')) ++slashes;
+
+        if ((slashes & 1) == 0) return end + 1;
+
+        pos = end + 1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief skips any JSON value without interpreting it.
+ * @return position after the value or 0 if value is malformed.
+ */
+static std::size_t skipValue (const char * message, std::size_t pos, const std::size_t length)
+{
+    if (pos >= length) return 0;
+
+    const char c = message[pos];
+    if (c == '"') return skipString(message, pos, length);
+
+    if ((c == '{') || (c == '['))
+    {
+        int depth = 0;
+        while (pos < length)
+        {
+            switch (message[pos])
+            {
+                case '"':
+                    pos = skipString(message, pos, length);
+                    if (pos == 0) return 0;
+                    continue;
+                case '{':
+                case '[':
+                    ++depth;
+                    break;
+                case '}':
+                case ']':
+                    --depth;
+                    if (depth == 0) return pos + 1;
+                    break;
+                case '\0':
+                    return 0;
+                default:
+                    break;
+            }
+            ++pos;
+        }
+        return 0;
+    }
+
+    // number, true, false, null
+    const std::size_t start = pos;
+    while ((pos < length) && (message[pos] != ',') && (message[pos] != '}') && (message[pos] != ']') && !isJsonWhiteSpace(message[pos]) && (message[pos] != '\0')) ++pos;
+
+    return (pos == start) ? 0 : pos;
+}
+
+
+static bool readInteger (const char * begin, const char * end, int& value)
+{
+    const std::from_chars_result result = std::from_chars(begin, end, value);
+    if ((result.ec == std::errc()) && (result.ptr == end)) return true;
+
+    // 1002.0 or 1.002e3 are still valid message types for nlohmann get<int>()
+    if ((begin == end) || !(std::isdigit(static_cast<unsigned char>(*begin)) || (*begin == '-'))) return false;
+    // strtod also reads inf, nan and hexadecimal, which are not JSON numbers.
+    for (const char * c = begin; c != end; ++c)
+    {
+        if (!(std::isdigit(static_cast<unsigned char>(*c)) || (*c == '-') || (*c == '+') || (*c == '.') || (*c == 'e') || (*c == 'E'))) return false;
+    }
+    char * parsed_end = nullptr;
+    const double real_value = std::strtod(begin, &parsed_end);
+    if (parsed_end != end) return false;
+    // casting a value that does not fit is undefined, and 1002.5 is no message type.
+    if (!std::isfinite(real_value) || (real_value != std::trunc(real_value))) return false;
+    if ((real_value < static_cast<double>(INT_MIN)) || (real_value > static_cast<double>(INT_MAX))) return false;
+    value = static_cast<int>(real_value);
+    return true;
+}
+
+
+static inline std::string_view stringContent (const char * message, const std::size_t value_begin, const std::size_t value_end)
+{
+    if (message[value_begin] != '"') return std::string_view();
+    return std::string_view(message + value_begin + 1, value_end - value_begin - 2);
+}
+
+
+/**
+ * @brief records binary part range.
+ * @details binary message layout is [JSON][0][binary][0].
+ * A text message is [JSON][0] so it has nothing after the separator.
+ */
+void CMessageEnvelope::setBinaryRange (const char * message, const std::size_t length)
+{
+    if ((m_json_end + 1 < length) && (message[m_json_end] == '\0'))
+    {
+        m_binary_begin = m_json_end + 1;
+        m_binary_end = length - 1;
+    }
+}
+
+
+bool CMessageEnvelope::scan (const char * message, const std::size_t length)
+{
+    *this = CMessageEnvelope();
+
+    std::size_t pos = skipWhiteSpace(message, 0, length);
+    if ((pos >= length) || (message[pos] != '{')) return false;
+
+    pos = skipWhiteSpace(message, pos + 1, length);
+    if ((pos < length) && (message[pos] == '}'))
+    {
+        m_json_end = pos + 1;
+        m_valid = true;
+        setBinaryRange(message, length);
+        return true;
+    }
+
+    while (pos < length)
+    {
+        // key
+        if (message[pos] != '"') return false;
+        const std::size_t key_end = skipString(message, pos, length);
+        if (key_end == 0) return false;
+        const std::string_view key(message + pos + 1, key_end - pos - 2);
+
+        pos = skipWhiteSpace(message, key_end, length);
+        if ((pos >= length) || (message[pos] != ':')) return false;
+        pos = skipWhiteSpace(message, pos + 1, length);
+
+        // value
+        const std::size_t value_begin = pos;
+        const std::size_t value_end = skipValue(message, pos, length);
+        if (value_end == 0) return false;
+
+        if (key == ANDRUAV_PROTOCOL_MESSAGE_TYPE)
+        {
+            m_has_message_type = readInteger(message + value_begin, message + value_end, m_message_type);
+        }
+        else if (key == ANDRUAV_PROTOCOL_MESSAGE_CMD)
+        {
+            m_cmd_begin = value_begin;
+            m_cmd_end = value_end;
+        }
+        else if (key == INTERMODULE_DELTA_HEADER)
+        {
+            m_delta_begin = value_begin;
+            m_delta_end = value_end;
+        }
+        else if (key == INTERMODULE_ROUTING_TYPE)
+        {
+            m_routing_type = stringContent(message, value_begin, value_end);
+        }
+        else if (key == ANDRUAV_PROTOCOL_TARGET_ID)
+        {
+            m_target_id = stringContent(message, value_begin, value_end);
+        }
+        else if (key == ANDRUAV_PROTOCOL_SENDER)
+        {
+            m_sender = stringContent(message, value_begin, value_end);
+        }
+        else if (key == ANDRUAV_PROTOCOL_GROUP_ID)
+        {
+            m_group_id = stringContent(message, value_begin, value_end);
+        }
+        else if (key == INTERMODULE_MODULE_KEY)
+        {
+            m_module_key = stringContent(message, value_begin, value_end);
+        }
+        else if (key == ANDRUAV_PROTOCOL_MESSAGE_PERMISSION)
+        {
+            // only unsigned integers are accepted as permission.
+            const std::from_chars_result result = std::from_chars(message + value_begin, message + value_end, m_permission);
+            m_has_permission = (result.ec == std::errc()) && (result.ptr == message + value_end);
+        }
+
+        pos = skipWhiteSpace(message, value_end, length);
+        if (pos >= length) return false;
+        if (message[pos] == '}')
+        {
+            m_json_end = pos + 1;
+            m_valid = true;
+            setBinaryRange(message, length);
+            return true;
+        }
+        if (message[pos] != ',') return false;
+        pos = skipWhiteSpace(message, pos + 1, length);
+    }
+
+    return false;
+}
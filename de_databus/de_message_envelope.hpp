@@ -0,0 +1,145 @@
+#ifndef DE_MESSAGE_ENVELOPE_H_
+#define DE_MESSAGE_ENVELOPE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief non-owning view of a byte range such as the binary part of a message.
+     */
+    class CByteSpan
+    {
+        public:
+
+            CByteSpan () = default;
+            CByteSpan (const char * data, const std::size_t size) : m_data(data), m_size(size) {}
+
+            inline const char * data () const { return m_data; }
+            inline std::size_t size () const { return m_size; }
+            inline bool empty () const { return m_size == 0; }
+            inline const char * begin () const { return m_data; }
+            inline const char * end () const { return m_data + m_size; }
+
+        private:
+
+            const char * m_data = nullptr;
+            std::size_t m_size = 0;
+    };
+
+
+    /**
+     * @brief routing fields of a databus message extracted without building a DOM.
+     * @details scan() walks the top level JSON object once in a SAX-like manner.
+     * Only top level keys are inspected. Nested values such as
+     * @link ANDRUAV_PROTOCOL_MESSAGE_CMD @endlink are skipped and only their byte range is recorded,
+     * so the cost does not depend on how big "ms" is.
+     *
+     * String fields are views into the scanned buffer and hold the raw JSON text
+     * between the quotes (escape sequences are not decoded). Routing fields never contain escapes.
+     * The scanned buffer must outlive the envelope.
+     */
+    class CMessageEnvelope
+    {
+        public:
+
+            /**
+             * @brief scans message envelope.
+             *
+             * @param message JSON text, optionally followed by 0 and binary data,
+             * then the 0 appended by @link CUDPClient @endlink.
+             * @param length buffer length including the appended 0.
+             * @return false if message is not a well formed JSON object.
+             */
+            bool scan (const char * message, const std::size_t length);
+
+        public:
+
+            inline bool isValid () const { return m_valid; }
+
+            inline bool hasMessageType () const { return m_has_message_type; }
+            inline int getMessageType () const { return m_message_type; }
+
+            inline bool hasPermission () const { return m_has_permission; }
+            inline uint32_t getPermission () const { return m_permission; }
+
+            inline bool hasRoutingType () const { return m_routing_type.data() != nullptr; }
+            inline std::string_view getRoutingType () const { return m_routing_type; }
+
+            inline bool hasSender () const { return m_sender.data() != nullptr; }
+            inline std::string_view getSender () const { return m_sender; }
+
+            inline std::string_view getTargetId () const { return m_target_id; }
+            inline std::string_view getGroupId () const { return m_group_id; }
+            inline std::string_view getModuleKey () const { return m_module_key; }
+
+            /**
+             * @brief true if message has @link ANDRUAV_PROTOCOL_MESSAGE_CMD @endlink field.
+             */
+            inline bool hasCmd () const { return m_cmd_end != 0; }
+            inline std::size_t getCmdBegin () const { return m_cmd_begin; }
+            inline std::size_t getCmdEnd () const { return m_cmd_end; }
+
+            /**
+             * @brief true if message is delta encoded. see @link CDeltaDecoder @endlink
+             * @details offsets are those of the raw @link INTERMODULE_DELTA_HEADER @endlink value.
+             */
+            inline bool hasDeltaHeader () const { return m_delta_end != 0; }
+            inline std::size_t getDeltaHeaderBegin () const { return m_delta_begin; }
+            inline std::size_t getDeltaHeaderEnd () const { return m_delta_end; }
+
+            /**
+             * @brief offset of the first byte after the closing '}' of the JSON object.
+             */
+            inline std::size_t getJsonEnd () const { return m_json_end; }
+
+            /**
+             * @brief true if JSON header is followed by 0 and a binary part. see @link CModule::sendBMSG @endlink
+             * @details decided from the recorded JSON end offset, not from the last bytes of the message.
+             */
+            inline bool isBinary () const { return m_binary_begin != 0; }
+
+            /**
+             * @brief binary part offsets. Both are zero for text messages.
+             * @details the 0 that @link CUDPClient @endlink appends after reassembly is excluded.
+             */
+            inline std::size_t getBinaryBegin () const { return m_binary_begin; }
+            inline std::size_t getBinaryEnd () const { return m_binary_end; }
+
+        private:
+
+            void setBinaryRange (const char * message, const std::size_t length);
+
+        private:
+
+            bool m_valid = false;
+
+            bool m_has_message_type = false;
+            int m_message_type = 0;
+
+            bool m_has_permission = false;
+            uint32_t m_permission = 0;
+
+            std::string_view m_routing_type;
+            std::string_view m_sender;
+            std::string_view m_target_id;
+            std::string_view m_group_id;
+            std::string_view m_module_key;
+
+            std::size_t m_cmd_begin = 0;
+            std::size_t m_cmd_end = 0;
+            std::size_t m_delta_begin = 0;
+            std::size_t m_delta_end = 0;
+            std::size_t m_json_end = 0;
+
+            std::size_t m_binary_begin = 0;
+            std::size_t m_binary_end = 0;
+    };
+}
+}
+
+#endif
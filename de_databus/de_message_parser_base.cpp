@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include "messages.hpp"
 #include "../helpers/helpers.hpp"
 #include "../helpers/colors.hpp"
@@ -9,53 +11,192 @@
 
 using namespace de::comm;
 
+CAndruavMessageParserBase::CAndruavMessageParserBase()
+{
+    m_default_handlers.setHandler(TYPE_AndruavMessage_CONFIG_ACTION, &CAndruavMessageParserBase::handleConfigAction);
+}
+
+/**
+ * @brief parses a message delivered as raw buffer and DOM.
+ * @details binary layout is [JSON][0][binary][0] where the last 0 is appended by CUDPClient.
+ * JSON text never contains a raw 0 so the first 0 ends the JSON header.
+ * Only the header is scanned, by the vectorized libc memchr, never the binary part.
+ * Envelope fields are read from the DOM.
+ */
 void CAndruavMessageParserBase::parseMessage(Json_de &andruav_message, const char *full_message, const int &full_message_length)
 {
-    const int messageType = andruav_message[ANDRUAV_PROTOCOL_MESSAGE_TYPE].get<int>();
-    m_is_binary = !(full_message[full_message_length - 1] == 125 || (full_message[full_message_length - 2] == 125)); // "}".charCodeAt(0)  IS TEXT / BINARY Msg
+    CMessageContext context;
+    const char *separator = static_cast<const char *>(std::memchr(full_message, 0, full_message_length));
+    if (separator != nullptr)
+    {
+        const int binary_begin = static_cast<int>(separator - full_message) + 1;
+        if (binary_begin < full_message_length)
+        {
+            context.binary_payload = CByteSpan(separator + 1, full_message_length - binary_begin - 1);
+        }
+    }
+    context.is_binary = (context.binary_payload.data() != nullptr);
 
-    uint32_t permission = 0;
+    context.message_type = andruav_message[ANDRUAV_PROTOCOL_MESSAGE_TYPE].get<int>();
     if (validateField(andruav_message, ANDRUAV_PROTOCOL_MESSAGE_PERMISSION, Json_de::value_t::number_unsigned))
     {
-        permission = andruav_message[ANDRUAV_PROTOCOL_MESSAGE_PERMISSION].get<int>();
+        context.permission = andruav_message[ANDRUAV_PROTOCOL_MESSAGE_PERMISSION].get<int>();
     }
-
-    m_is_system = false;
-    if ((validateField(andruav_message, ANDRUAV_PROTOCOL_SENDER, Json_de::value_t::string)) && (andruav_message[ANDRUAV_PROTOCOL_SENDER].get<std::string>().compare(ANDRUAV_PROTOCOL_SENDER_COMM_SERVER) == 0))
+    if (validateField(andruav_message, ANDRUAV_PROTOCOL_SENDER, Json_de::value_t::string))
+    {
+        context.sender = andruav_message[ANDRUAV_PROTOCOL_SENDER].get_ref<const std::string &>();
+    }
+    if (validateField(andruav_message, INTERMODULE_ROUTING_TYPE, Json_de::value_t::string))
     {
-        m_is_system = true;
+        context.routing_type = andruav_message[INTERMODULE_ROUTING_TYPE].get_ref<const std::string &>();
     }
 
-    m_is_inter_module = false;
-    if ((validateField(andruav_message, INTERMODULE_ROUTING_TYPE, Json_de::value_t::string)) && (andruav_message[INTERMODULE_ROUTING_TYPE].get<std::string>().compare(CMD_TYPE_INTERMODULE) == 0))
+    dispatchMessage(andruav_message, full_message, full_message_length, context);
+}
+
+/**
+ * @brief parses a message received through the lazy CModule callback.
+ * @details envelope fields and binary part offsets were recorded while scanning the envelope
+ * so nothing is scanned or looked up in the DOM here. The DOM is moved out of inbound_message.
+ */
+void CAndruavMessageParserBase::parseMessage(CInboundMessage &inbound_message)
+{
+    const CMessageEnvelope &envelope = inbound_message.getEnvelope();
+
+    CMessageContext context;
+    context.message_type = envelope.getMessageType();
+    if (envelope.hasPermission()) context.permission = envelope.getPermission();
+    context.sender = envelope.getSender();
+    context.routing_type = envelope.getRoutingType();
+    context.is_binary = inbound_message.isBinary();
+    if (context.is_binary) context.binary_payload = inbound_message.getBinaryPayload();
+
+    Json_de andruav_message = inbound_message.takeJson();
+    dispatchMessage(andruav_message, inbound_message.getMessage(), static_cast<int>(inbound_message.getLength()), context);
+}
+
+void CAndruavMessageParserBase::dispatchMessage(Json_de &andruav_message, const char *full_message, const int &full_message_length, CMessageContext &context)
+{
+    context.is_system = (context.sender == ANDRUAV_PROTOCOL_SENDER_COMM_SERVER);
+    context.is_inter_module = (context.routing_type == CMD_TYPE_INTERMODULE);
+
+    if (context.message_type == TYPE_AndruavMessage_RemoteExecute)
     {
-        m_is_inter_module = true;
+        // const lookups so a message without "ms" is not given a null one.
+        const Json_de &message = andruav_message;
+        const Json_de::const_iterator cmd = message.find(ANDRUAV_PROTOCOL_MESSAGE_CMD);
+        if ((cmd != message.end()) && cmd->contains("C") && (*cmd)["C"].is_number_integer())
+        {
+            const RemoteExecuteHandler *handler = m_remote_execute_handlers.findHandler((*cmd)["C"].get<int>());
+            if (handler != nullptr)
+            {
+                (*handler)(andruav_message, *cmd, context);
+                return;
+            }
+        }
+
+        parseRemoteExecute(andruav_message, context);
+        return;
     }
 
-    if (messageType == TYPE_AndruavMessage_RemoteExecute)
+    parseDefaultCommand(andruav_message, context);
+
+    const MessageHandler *handler = m_handlers.findHandler(context.message_type);
+    if (handler != nullptr)
     {
-        parseRemoteExecute(andruav_message);
+        (*handler)(andruav_message, full_message, full_message_length, context);
         return;
     }
 
-    parseDefaultCommand(andruav_message, full_message, full_message_length, messageType, permission);
-    parseCommand(andruav_message, full_message, full_message_length, messageType, permission);
+    parseCommand(andruav_message, full_message, full_message_length, context);
 }
 
-void CAndruavMessageParserBase::parseDefaultCommand(Json_de &andruav_message, const char *full_message, const int &full_message_length, int messageType, uint32_t permission)
+// legacy hooks are called here only, to keep parsers that override them working.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+void CAndruavMessageParserBase::parseRemoteExecute(Json_de &andruav_message, const CMessageContext &context)
 {
-    const Json_de cmd = andruav_message[ANDRUAV_PROTOCOL_MESSAGE_CMD];
+    m_is_binary = context.is_binary;
+    m_is_system = context.is_system;
+    m_is_inter_module = context.is_inter_module;
+    parseRemoteExecute(andruav_message);
+}
 
-    switch (messageType)
-    {
-    case TYPE_AndruavMessage_CONFIG_ACTION:
+void CAndruavMessageParserBase::parseCommand(Json_de &andruav_message, const char *full_message, const int &full_message_length, const CMessageContext &context)
+{
+    m_is_binary = context.is_binary;
+    m_is_system = context.is_system;
+    m_is_inter_module = context.is_inter_module;
+    parseCommand(andruav_message, full_message, full_message_length, context.message_type, context.permission);
+}
+
+#pragma GCC diagnostic pop
+
+/**
+ * @brief reached only when neither hook is overridden.
+ */
+void CAndruavMessageParserBase::parseRemoteExecute(Json_de &)
+{
+    countUnhandledMessage(TYPE_AndruavMessage_RemoteExecute);
+}
+
+void CAndruavMessageParserBase::parseCommand(Json_de &, const char *, const int &, int messageType, uint32_t)
+{
+    countUnhandledMessage(messageType);
+}
+
+void CAndruavMessageParserBase::countUnhandledMessage(const int message_type)
+{
+    std::lock_guard<std::mutex> lock(m_unhandled_lock);
+    if (m_unhandled_messages[message_type]++ == 0)
     {
-        handleConfigAction(andruav_message, cmd);
-    }
-    break;
+        std::cout << _INFO_CONSOLE_TEXT << "no handler for message type " << message_type << _NORMAL_CONSOLE_TEXT_ << std::endl;
     }
 }
 
+std::map<int, uint64_t> CAndruavMessageParserBase::getUnhandledMessageCounts() const
+{
+    std::lock_guard<std::mutex> lock(m_unhandled_lock);
+    return m_unhandled_messages;
+}
+
+void CAndruavMessageParserBase::parseDefaultCommand(Json_de &andruav_message, const CMessageContext &context)
+{
+    const DefaultHandler *handler = m_default_handlers.findHandler(context.message_type);
+    if (handler == nullptr)
+        return;
+
+    const Json_de &message = andruav_message;
+    const Json_de::const_iterator cmd = message.find(ANDRUAV_PROTOCOL_MESSAGE_CMD);
+    if (cmd == message.end())
+        return;
+
+    (this->**handler)(andruav_message, *cmd);
+}
+
+/**
+ * @brief registers a handler for a message type.
+ * @details registered handlers are called instead of parseCommand().
+ * Common commands such as TYPE_AndruavMessage_CONFIG_ACTION are still handled by this class first.
+ * Pass an empty handler to remove it.
+ */
+void CAndruavMessageParserBase::registerHandler(const int message_type, MessageHandler handler)
+{
+    m_handlers.setHandler(message_type, std::move(handler));
+}
+
+/**
+ * @brief registers a handler for a TYPE_AndruavMessage_RemoteExecute sub-command.
+ * @details command_type is the "C" field. It can be a RemoteCommand_* or a message type i.e. TYPE_AndruavMessage_ID.
+ * Registered handlers are called instead of parseRemoteExecute().
+ * Pass an empty handler to remove it.
+ */
+void CAndruavMessageParserBase::registerRemoteExecuteHandler(const int command_type, RemoteExecuteHandler handler)
+{
+    m_remote_execute_handlers.setHandler(command_type, std::move(handler));
+}
+
 void CAndruavMessageParserBase::handleConfigAction(Json_de &andruav_message, const Json_de &cmd)
 {
     std::string module_key = "";
@@ -1,35 +1,105 @@
 #ifndef ANDRUAV_MESSAGE_PARSER_BASE_H_
 #define ANDRUAV_MESSAGE_PARSER_BASE_H_
 
-#include "de_message_parser_base.hpp"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string_view>
+
 #include "de_facade_base.hpp"
+#include "de_dispatch_table.hpp"
 
-#include "../helpers/json_nlohmann.hpp"
-using Json_de = nlohmann::json;
+#include "../helpers/json_de.hpp"
 
 namespace de
 {
     namespace comm
     {
+        /**
+         * @brief envelope fields of the message being parsed.
+         * @details filled once per message by parseMessage and passed down to handlers,
+         * so the parser keeps no per-message state and several threads can parse at the same time.
+         * Views refer to the received message or its DOM and are valid during dispatch only.
+         */
+        struct CMessageContext
+        {
+            int message_type = 0;
+            uint32_t permission = 0;
+            std::string_view sender;
+            std::string_view routing_type;
+            // sent by the communication server.
+            bool is_system = false;
+            bool is_inter_module = false;
+            bool is_binary = false;
+            // binary part of the message. Empty for text messages.
+            CByteSpan binary_payload;
+        };
+
+
         class CAndruavMessageParserBase
         {
         public:
+            typedef std::function<void(Json_de &andruav_message, const char *full_message, const int &full_message_length, const CMessageContext &context)> MessageHandler;
+            typedef std::function<void(Json_de &andruav_message, const Json_de &cmd, const CMessageContext &context)> RemoteExecuteHandler;
+
+        public:
+            CAndruavMessageParserBase();
             virtual ~CAndruavMessageParserBase() {}
 
             void parseMessage(Json_de &andruav_message, const char *full_message, const int &full_message_length);
+            void parseMessage(CInboundMessage &inbound_message);
+
+            void registerHandler(const int message_type, MessageHandler handler);
+            void registerRemoteExecuteHandler(const int command_type, RemoteExecuteHandler handler);
+
+            /**
+             * @brief per message type count of messages that reached no registered handler
+             * and no parseCommand() or parseRemoteExecute() override.
+             * @details the first such message of each type is also logged.
+             */
+            std::map<int, uint64_t> getUnhandledMessageCounts() const;
 
         protected:
-            virtual void parseRemoteExecute(Json_de &andruav_message) = 0;
-            virtual void parseCommand(Json_de &andruav_message, const char *full_message, const int &full_message_length, int messageType, uint32_t permission) = 0;
+            /**
+             * @brief fallbacks for message types that have no registered handler.
+             * @details default implementations set the legacy members below and call the legacy hooks,
+             * so parsers written against them are still called.
+             */
+            virtual void parseRemoteExecute(Json_de &andruav_message, const CMessageContext &context);
+            virtual void parseCommand(Json_de &andruav_message, const char *full_message, const int &full_message_length, const CMessageContext &context);
+
+            /**
+             * @deprecated override the CMessageContext overloads instead.
+             * @details called only when the CMessageContext overload is not overridden.
+             * They read m_is_binary, m_is_system and m_is_inter_module, so such parsers must not parse from several threads.
+             */
+            [[deprecated("override parseRemoteExecute(Json_de &, const CMessageContext &)")]]
+            virtual void parseRemoteExecute(Json_de &);
+            [[deprecated("override parseCommand(Json_de &, const char *, const int &, const CMessageContext &)")]]
+            virtual void parseCommand(Json_de &, const char *, const int &, int messageType, uint32_t);
 
         private:
-            void parseDefaultCommand(Json_de &andruav_message, const char *full_message, const int &full_message_length, int messageType, uint32_t permission);
+            void dispatchMessage(Json_de &andruav_message, const char *full_message, const int &full_message_length, CMessageContext &context);
+            void parseDefaultCommand(Json_de &andruav_message, const CMessageContext &context);
             void handleConfigAction(Json_de &andruav_message, const Json_de &cmd);
+            void countUnhandledMessage(const int message_type);
+
+        private:
+            typedef void (CAndruavMessageParserBase::*DefaultHandler)(Json_de &andruav_message, const Json_de &cmd);
+
+            CDispatchTable<DefaultHandler> m_default_handlers;
+            CDispatchTable<MessageHandler> m_handlers;
+            CDispatchTable<RemoteExecuteHandler> m_remote_execute_handlers;
+
+            mutable std::mutex m_unhandled_lock;
+            std::map<int, uint64_t> m_unhandled_messages;
 
         protected:
-            bool m_is_binary;
-            bool m_is_system;
-            bool m_is_inter_module;
+            // @deprecated set before the legacy hooks are called. Use CMessageContext instead.
+            bool m_is_binary = false;
+            bool m_is_system = false;
+            bool m_is_inter_module = false;
 
             de::comm::CFacade_Base &m_facade = de::comm::CFacade_Base::getInstance();
         };
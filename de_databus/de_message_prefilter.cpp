@@ -0,0 +1,78 @@
+#include <cstring>
+
+#include "messages.hpp"
+#include "de_routing_prefix.hpp"
+#include "de_message_envelope.hpp"
+#include "de_message_prefilter.hpp"
+
+using namespace de::comm;
+
+
+bool de::comm::peekMessageType (const char * message, const std::size_t length, int& message_type)
+{
+    if (hasRoutingPrefix(message, length))
+    {
+        ROUTING_PREFIX prefix;
+        if (!readRoutingPrefix(message, length, prefix)) return false;
+        message_type = prefix.message_type;
+        return true;
+    }
+
+    if ((length == 0) || (message[0] != '{')) return false;
+
+    // JSON text never contains a raw 0, so the first 0 ends it and the binary part is never scanned.
+    const char * json_end = static_cast<const char *>(std::memchr(message, 0, length));
+    const std::size_t json_length = (json_end == nullptr) ? length : static_cast<std::size_t>(json_end - message) + 1;
+
+    CMessageEnvelope envelope;
+    if (!envelope.scan(message, json_length) || !envelope.hasMessageType()) return false;
+
+    message_type = envelope.getMessageType();
+    return true;
+}
+
+
+void CMessagePrefilter::setMessageTypes (const Json_de& message_types)
+{
+    std::vector<uint8_t> subscribed;
+    if (message_types.is_array())
+    {
+        for (const Json_de& message_type : message_types)
+        {
+            if (!message_type.is_number_integer()) continue;
+            const int64_t type = message_type.get<int64_t>();
+            if ((type < 0) || (type > MESSAGE_PREFILTER_MAX_TYPE)) continue;
+
+            if (static_cast<std::size_t>(type) >= subscribed.size()) subscribed.resize(type + 1, 0);
+            subscribed[type] = 1;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_subscribed.swap(subscribed);
+}
+
+
+bool CMessagePrefilter::accept (const char * message, const std::size_t length)
+{
+    if (!m_enabled.load(std::memory_order_relaxed)) return true;
+
+    int message_type;
+    if (!peekMessageType(message, length, message_type)) return true;
+
+    std::lock_guard<std::mutex> lock(m_lock);
+    const bool passed = ((message_type >= MESSAGE_PREFILTER_CONTROL_FIRST) && (message_type <= MESSAGE_PREFILTER_CONTROL_LAST))
+                      || ((message_type >= 0) && (static_cast<std::size_t>(message_type) < m_subscribed.size()) && (m_subscribed[message_type] != 0));
+
+    MESSAGE_PREFILTER_COUNTERS& counters = m_counters[message_type];
+    if (passed) ++counters.passed;
+    else ++counters.filtered;
+    return passed;
+}
+
+
+std::map<int, MESSAGE_PREFILTER_COUNTERS> CMessagePrefilter::getCounters ()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    return m_counters;
+}
@@ -0,0 +1,76 @@
+#ifndef DE_MESSAGE_PREFILTER_H_
+#define DE_MESSAGE_PREFILTER_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "../helpers/json_de.hpp"
+
+
+// databus and module control messages. Always passed whatever the module subscribed to.
+#define MESSAGE_PREFILTER_CONTROL_FIRST     9000
+#define MESSAGE_PREFILTER_CONTROL_LAST      9999
+// larger subscribed types are ignored. User messages end at 90000.
+#define MESSAGE_PREFILTER_MAX_TYPE          0xFFFFF
+
+
+typedef struct
+{
+    uint64_t passed;
+    uint64_t filtered;
+} MESSAGE_PREFILTER_COUNTERS;
+
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief finds message type of a received message without parsing it.
+     * @details reads the routing prefix when present. Otherwise the top level keys of the JSON text
+     * are scanned by CMessageEnvelope, in any order. Nested values are skipped and the scan stops
+     * at the first 0, so binary payloads are never scanned.
+     * @return false if not found, e.g. encoded frames or malformed JSON. Such messages are not filtered.
+     */
+    bool peekMessageType (const char * message, const std::size_t length, int& message_type);
+
+
+    /**
+     * @brief drops message types a module did not subscribe to before they are parsed.
+     * @details subscribed types are a flat table indexed by message type. Counts passed
+     * and filtered messages per type. Thread safe: accept() runs in the receive thread.
+     */
+    class CMessagePrefilter
+    {
+        public:
+
+            /**
+             * @param message_types JSON array of message types. see CModule::defineModule
+             */
+            void setMessageTypes (const Json_de& message_types);
+
+            inline void setEnabled (const bool enabled) { m_enabled = enabled; }
+
+            /**
+             * @return false if message should be dropped.
+             */
+            bool accept (const char * message, const std::size_t length);
+
+            std::map<int, MESSAGE_PREFILTER_COUNTERS> getCounters ();
+
+        private:
+
+            std::mutex m_lock;
+            std::atomic<bool> m_enabled {false};
+            // non zero for subscribed types. Types beyond the end are not subscribed.
+            std::vector<uint8_t> m_subscribed;
+            std::map<int, MESSAGE_PREFILTER_COUNTERS> m_counters;
+    };
+}
+}
+
+#endif
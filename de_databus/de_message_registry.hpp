@@ -0,0 +1,250 @@
+#ifndef DE_MESSAGE_REGISTRY_H_
+#define DE_MESSAGE_REGISTRY_H_
+
+#include <cstdint>
+#include <cstddef>
+
+#include "messages.hpp"
+
+typedef enum {
+    MESSAGE_PRIORITY_LOW            = 0,    // bulk data i.e. images, spectrum, files.
+    MESSAGE_PRIORITY_NORMAL         = 1,    // telemetry & status.
+    MESSAGE_PRIORITY_HIGH           = 2,    // commands & errors.
+} ENUM_MESSAGE_PRIORITY;
+
+
+#define MESSAGE_FORMAT_TEXT     false
+#define MESSAGE_FORMAT_BINARY   true
+
+#define MESSAGE_COMMAND         false
+#define MESSAGE_STATE           true
+
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief compile time properties of a message type.
+     * @details
+     * is_binary: message is sent by sendBMSG with a binary part.
+     * priority: default priority of the message.
+     * is_coalescable: message carries a state where only the latest value matters
+     *                 so a newer instance can replace an older one that is not sent/delivered yet.
+     *                 Commands are never coalescable.
+     * The handler slot of a type is its index in MESSAGE_TYPE_REGISTRY. see getMessageTypeSlot().
+     */
+    struct CMessageTypeInfo
+    {
+        int message_type;
+        bool is_binary;
+        ENUM_MESSAGE_PRIORITY priority;
+        bool is_coalescable;
+        const char * name;
+    };
+
+
+    #define DE_MESSAGE_TYPE(message_type, format, priority, kind) \
+        { message_type, format, priority, kind, #message_type }
+
+    constexpr CMessageTypeInfo MESSAGE_TYPE_REGISTRY[] =
+    {
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_GPS,                            MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_POWER,                          MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_ID,                             MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_RemoteExecute,                  MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_IMG,                            MESSAGE_FORMAT_BINARY,  MESSAGE_PRIORITY_LOW,       MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Error,                          MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_FlightControl,                  MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_CameraList,                     MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_DroneReport,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Signaling,                      MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_HomeLocation,                   MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_GeoFence,                       MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_ExternalGeoFence,               MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_GEOFenceHit,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_WayPoints,                      MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_GeoFenceAttachStatus,           MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Arm,                            MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_ChangeAltitude,                 MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Land,                           MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_GuidedPoint,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_CirclePoint,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_DoYAW,                          MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_NAV_INFO,                       MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_DistinationLocation,            MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_ConfigCOM,                      MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_ConfigFCB,                      MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_ChangeSpeed,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Ctrl_Cameras,                   MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_TrackingTarget_ACTION,          MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_TrackingTargetLocation,         MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_TargetTracking_STATUS,          MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_UploadWayPoints,                MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_RemoteControlSettings,          MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_SET_HOME_LOCATION,              MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_CameraZoom,                     MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_CameraSwitch,                   MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_CameraFlash,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_RemoteControl2,                 MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_SensorsStatus,                  MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_FollowHim_Request,              MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_FollowMe_Guided,                MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Make_Swarm,                     MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_SwarmReport,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_UpdateSwarm,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_CommSignalsStatus,              MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Sync_EventFire,                 MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_SearchTargetList,               MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Prepherials,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_UDPProxy_Info,                  MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Unit_Name,                      MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Ping_Unit,                      MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Upload_DE_Mission,              MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_AI_Recognition_ACTION,          MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_AI_Recognition_STATUS,          MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_AI_Recognition_TargetLocation,  MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_LightTelemetry,                 MESSAGE_FORMAT_BINARY,  MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_ServoChannel,                   MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_MAVLINK,                        MESSAGE_FORMAT_BINARY,  MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_SWARM_MAVLINK,                  MESSAGE_FORMAT_BINARY,  MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_INTERNAL_MAVLINK,               MESSAGE_FORMAT_BINARY,  MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_P2P_ACTION,                     MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_P2P_STATUS,                     MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_P2P_InRange_BSSID,              MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_P2P_InRange_Node,               MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Communication_Line_Set,         MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Communication_Line_Status,      MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_SOUND_TEXT_TO_SPEECH,           MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_SOUND_PLAY_FILE,                MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_SDR_ACTION,                     MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_SDR_REMOTE_EXECUTE,             MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_SDR_SPECTRUM,                   MESSAGE_FORMAT_BINARY,  MESSAGE_PRIORITY_LOW,       MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_P2P_INFO,                       MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_Mission_Item_Sequence,          MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_GPIO_ACTION,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_GPIO_STATUS,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_GPIO_REMOTE_EXECUTE,            MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_LocalServer_ACTION,             MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_LocalServer_STATUS,             MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_LocalServer_REMOTE_EXECUTE,     MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_CONFIG_ACTION,                  MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_CONFIG_STATUS,                  MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavMessage_DUMMY,                          MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_LOW,       MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavSystem_LoadTasks,                       MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavSystem_SaveTasks,                       MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavSystem_DeleteTasks,                     MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavSystem_DisableTasks,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavSystem_Ping,                            MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavSystem_LogoutCommServer,                MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavSystem_ConnectedCommServer,             MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavSystem_UDPProxy,                        MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavSystem_LocalServer,                     MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavModule_ID,                              MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavModule_RemoteExecute,                   MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+        DE_MESSAGE_TYPE(TYPE_AndruavModule_Location_Info,                   MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_NORMAL,    MESSAGE_STATE),
+        DE_MESSAGE_TYPE(TYPE_AndruavModule_Subscription,                    MESSAGE_FORMAT_TEXT,    MESSAGE_PRIORITY_HIGH,      MESSAGE_COMMAND),
+    };
+
+    #undef DE_MESSAGE_TYPE
+
+    constexpr std::size_t MESSAGE_TYPE_COUNT = sizeof(MESSAGE_TYPE_REGISTRY) / sizeof(MESSAGE_TYPE_REGISTRY[0]);
+
+
+    namespace registry_detail
+    {
+        /**
+         * @brief open addressing table that maps message type to registry slot.
+         * @details built at compile time so slot lookup is a hash and usually a single probe.
+         */
+        constexpr std::size_t SLOT_TABLE_SIZE = 256;
+        constexpr std::size_t SLOT_TABLE_MASK = SLOT_TABLE_SIZE - 1;
+
+        static_assert(MESSAGE_TYPE_COUNT * 2 <= SLOT_TABLE_SIZE, "increase SLOT_TABLE_SIZE");
+
+        constexpr std::size_t hashMessageType (const int message_type)
+        {
+            return (static_cast<uint32_t>(message_type) * 2654435761u) >> 24;
+        }
+
+        struct CSlotTable
+        {
+            int16_t slots[SLOT_TABLE_SIZE];
+        };
+
+        constexpr CSlotTable buildSlotTable ()
+        {
+            CSlotTable table {};
+            for (std::size_t i = 0; i < SLOT_TABLE_SIZE; ++i) table.slots[i] = -1;
+
+            for (std::size_t slot = 0; slot < MESSAGE_TYPE_COUNT; ++slot)
+            {
+                std::size_t index = hashMessageType(MESSAGE_TYPE_REGISTRY[slot].message_type) & SLOT_TABLE_MASK;
+                while (table.slots[index] != -1) index = (index + 1) & SLOT_TABLE_MASK;
+                table.slots[index] = static_cast<int16_t>(slot);
+            }
+
+            return table;
+        }
+
+        constexpr bool hasUniqueMessageTypes ()
+        {
+            for (std::size_t i = 0; i < MESSAGE_TYPE_COUNT; ++i)
+                for (std::size_t j = i + 1; j < MESSAGE_TYPE_COUNT; ++j)
+                    if (MESSAGE_TYPE_REGISTRY[i].message_type == MESSAGE_TYPE_REGISTRY[j].message_type) return false;
+            return true;
+        }
+
+        static_assert(hasUniqueMessageTypes(), "message type is registered twice in MESSAGE_TYPE_REGISTRY");
+
+        constexpr CSlotTable SLOT_TABLE = buildSlotTable();
+    }
+
+
+    /**
+     * @brief dense registry index of a message type.
+     * @return -1 if message type is not registered i.e. user defined message types.
+     */
+    constexpr int getMessageTypeSlot (const int message_type)
+    {
+        std::size_t index = registry_detail::hashMessageType(message_type) & registry_detail::SLOT_TABLE_MASK;
+        while (registry_detail::SLOT_TABLE.slots[index] != -1)
+        {
+            const int slot = registry_detail::SLOT_TABLE.slots[index];
+            if (MESSAGE_TYPE_REGISTRY[slot].message_type == message_type) return slot;
+            index = (index + 1) & registry_detail::SLOT_TABLE_MASK;
+        }
+
+        return -1;
+    }
+
+
+    /**
+     * @return message type properties or nullptr if message type is not registered.
+     */
+    constexpr const CMessageTypeInfo * getMessageTypeInfo (const int message_type)
+    {
+        const int slot = getMessageTypeSlot(message_type);
+        return (slot == -1) ? nullptr : &MESSAGE_TYPE_REGISTRY[slot];
+    }
+
+
+    constexpr bool isMessageCoalescable (const int message_type)
+    {
+        const CMessageTypeInfo * info = getMessageTypeInfo(message_type);
+        return (info != nullptr) && info->is_coalescable;
+    }
+
+
+    constexpr const char * getMessageTypeName (const int message_type)
+    {
+        const CMessageTypeInfo * info = getMessageTypeInfo(message_type);
+        return (info == nullptr) ? "UNKNOWN" : info->name;
+    }
+
+    static_assert(getMessageTypeSlot(TYPE_AndruavMessage_GPS) == 0, "registry slot lookup is broken");
+    static_assert(getMessageTypeSlot(TYPE_AndruavMessage_USER_RANGE_START) == -1, "registry slot lookup is broken");
+}
+}
+
+#endif
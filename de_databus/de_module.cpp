@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
 #include "../helpers/colors.hpp"
 #include "de_module.hpp"
 
@@ -15,11 +19,15 @@ void de::comm::CModule::defineModule (
                  Json_de message_filter
             ) 
 {
+    std::lock_guard<std::mutex> lock(m_lock);
+
     m_module_class = module_class;
     m_module_id = module_id;
     m_module_key = module_key;
     m_module_version = module_version;
     m_message_filter = message_filter;
+    m_message_prefilter.setMessageTypes(message_filter);
+    resetMavlinkStreams();
     return ;
 }
 
@@ -29,7 +37,10 @@ bool de::comm::CModule::init (const std::string targetIP, int broadcatsPort, con
     // UDP Server
     cUDPClient.init(targetIP.c_str(), broadcatsPort, host.c_str() ,listenningPort, chunkSize);
     
-    createJSONID(true);
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        createJSONID(true);
+    }
     cUDPClient.start();
 
     return true;
@@ -38,7 +49,10 @@ bool de::comm::CModule::init (const std::string targetIP, int broadcatsPort, con
 
 bool de::comm::CModule::uninit ()
 {
+    stopMavlinkBatching();
+    stopOutboundQueue();
     cUDPClient.stop();
+    stopInboundMailbox();
 
     return true;
 }
@@ -53,11 +67,122 @@ void de::comm::CModule::sendSYSMSG (const Json_de& jmsg, const int& andruav_mess
     fullMessage[ANDRUAV_PROTOCOL_MESSAGE_TYPE]      = andruav_message_id;
     fullMessage[ANDRUAV_PROTOCOL_MESSAGE_CMD]       = jmsg;
     
-    const std::string& msg = fullMessage.dump();
+    std::string msg = fullMessage.dump();
     #ifdef DEBUG
         //std::cout << "sendJMSG:" << msg.c_str() << std::endl;
     #endif
-    sendMSG(msg.c_str(), msg.length());         
+    std::lock_guard<std::mutex> lock(m_lock);
+    queueMSG(std::move(msg), andruav_message_id, addParty(ANDRUAV_PROTOCOL_SENDER_COMM_SERVER), CMD_COMM_SYSTEM);
+}
+
+
+/**
+ * @brief selects routing type of an outgoing message.
+ * @details
+ *  Internally: i.e. DroneEngage Communication module will handle it and will resend it to other modules
+ *                  or modulated then forwarded to Cmmunication Server.
+ *  Group: i.e. to all members of groups.
+ *  Individual: i.e. to a given member or a certain type of members i.e. all vehicles or all GCS.
+ */
+static const char * getRoutingType (const std::string_view targetPartyID, const bool internal_message)
+{
+    if (internal_message == true) return CMD_TYPE_INTERMODULE;
+    
+    if (targetPartyID.length() != 0) return CMD_COMM_INDIVIDUAL;
+
+    return CMD_COMM_GROUP;
+}
+
+
+/**
+ * @brief serializes message envelope and its @link ANDRUAV_PROTOCOL_MESSAGE_CMD @endlink section into out.
+ * @details JSON text unless a binary wire encoding is negotiated. see @link serializeEncodedMessage @endlink
+ * Large messages are then compressed if a dictionary is negotiated.
+ * must be called while m_lock is held.
+ * @param delta_header written as @link INTERMODULE_DELTA_HEADER @endlink if message_cmd is delta encoded.
+ */
+void de::comm::CModule::serializeMessage (std::string& out, const PARTY_HANDLE target_party, const char * msg_routing_type, const int andruav_message_id, const Json_de& message_cmd, const DELTA_HEADER * delta_header) const
+{
+    if (m_wire_encoding != DATABUS_ENCODING_JSON)
+    {
+        const SESSION_ALIASES aliases = {m_module_key_alias, m_party_table.getAlias(target_party)};
+        serializeEncodedMessage(out, m_wire_encoding, m_module_key, andruav_message_id, m_party_table.getPartyId(target_party), msg_routing_type, message_cmd, delta_header, &aliases);
+    }
+    else
+    {
+        serializeJsonMessage(out, target_party, msg_routing_type, andruav_message_id, message_cmd, delta_header);
+    }
+
+    if (m_dictionary_accepted)
+    {
+        compressFrame(out, *m_dictionary_codec, m_dictionary_min_size);
+    }
+}
+
+
+/**
+ * @brief serializes message as JSON text.
+ * @details envelope fields are written directly and message_cmd is dumped after them,
+ * so no temporary envelope DOM is built and nothing is allocated if out has enough capacity.
+ * Fields are written as GU, mt, tg, ty, ms then the delta header, so the message type comes before
+ * the command. A dumped Json_de envelope sorts keys instead (ms before mt). Receivers accept any order.
+ * Session aliases replace module key and target id when the communicator assigned them.
+ */
+void de::comm::CModule::serializeJsonMessage (std::string& out, const PARTY_HANDLE target_party, const char * msg_routing_type, const int andruav_message_id, const Json_de& message_cmd, const DELTA_HEADER * delta_header) const
+{
+
+    out.clear();
+
+    char number[16];
+    if (m_module_key_alias != 0)
+    {
+        const std::to_chars_result result = std::to_chars(number, number + sizeof(number), m_module_key_alias);
+        out += "{\"" INTERMODULE_MODULE_KEY_ALIAS "\":";
+        out.append(number, result.ptr - number);
+    }
+    else
+    {
+        out += "{\"" INTERMODULE_MODULE_KEY "\":";
+        appendJsonString(out, m_module_key);
+    }
+
+    const std::to_chars_result result = std::to_chars(number, number + sizeof(number), andruav_message_id);
+    out += ",\"" ANDRUAV_PROTOCOL_MESSAGE_TYPE "\":";
+    out.append(number, result.ptr - number);
+
+    // targetID can exist even if routing is intermodule
+    const uint16_t target_alias = m_party_table.getAlias(target_party);
+    if (target_alias != 0)
+    {
+        const std::to_chars_result alias_result = std::to_chars(number, number + sizeof(number), target_alias);
+        out += ",\"" INTERMODULE_TARGET_ID_ALIAS "\":";
+        out.append(number, alias_result.ptr - number);
+    }
+    else
+    {
+        out += ",\"" ANDRUAV_PROTOCOL_TARGET_ID "\":";
+        appendJsonString(out, m_party_table.getPartyId(target_party));
+    }
+
+    out += ",\"" INTERMODULE_ROUTING_TYPE "\":";
+    appendJsonString(out, msg_routing_type);
+
+    out += ",\"" ANDRUAV_PROTOCOL_MESSAGE_CMD "\":";
+    const std::map<int, JSON_FIELD_PRECISION>::const_iterator precision = m_field_precision.find(andruav_message_id);
+    appendJson(out, message_cmd, (precision == m_field_precision.end()) ? nullptr : &precision->second);
+
+    if (delta_header != nullptr)
+    {
+        out += ",\"" INTERMODULE_DELTA_HEADER "\":[";
+        out += std::to_string(delta_header->sequence);
+        if (!delta_header->keyframe)
+        {
+            out.push_back(',');
+            out += std::to_string(delta_header->base_sequence);
+        }
+        out.push_back(']');
+    }
+    out.push_back('}');
 }
 
 
@@ -71,107 +196,1030 @@ void de::comm::CModule::sendSYSMSG (const Json_de& jmsg, const int& andruav_mess
  * @param andruav_message_id 
  * @param internal_message if true @link INTERMODULE_MODULE_KEY @endlink equaqls to Module key
  */
-void de::comm::CModule::sendJMSG (const std::string targetPartyID, const Json_de jmsg, const int andruav_message_id, const bool internal_message)
+void de::comm::CModule::sendJMSG (const std::string_view targetPartyID, const Json_de& jmsg, const int andruav_message_id, const bool internal_message)
 {
     std::lock_guard<std::mutex> lock(m_lock);
                 
-    Json_de fullMessage;
+    std::string msg = CBufferPool::getThreadInstance().acquire(BUFFER_POOL_MIN_SIZE);
+    const PARTY_HANDLE target_party = internParty(targetPartyID);
+    const char * msg_routing_type = getRoutingType(targetPartyID, internal_message);
 
-    /**
-    // Route messages:
-    //  Internally: i.e. DroneEngage Communication module will handle it and will resend it to other modules
-    //                  or modulated then forwarded to Cmmunication Server.
-    //  Group: i.e. to all members of groups.
-    //  Individual: i.e. to a given member or a certain type of members i.e. all vehicles or all GCS.
-    */
-    std::string msg_routing_type = CMD_COMM_GROUP;
-    if (internal_message == true)
+    const std::map<int, DELTA_ENCODING_CONFIG>::const_iterator delta_config = m_delta_config.find(andruav_message_id);
+    if (m_delta_accepted && (delta_config != m_delta_config.end()))
     {
-        msg_routing_type = CMD_TYPE_INTERMODULE;
+        DELTA_HEADER delta_header;
+        const Json_de& message_cmd = m_delta_encoder.encode(target_party, andruav_message_id, jmsg, delta_config->second, delta_header);
+        serializeMessage(msg, target_party, msg_routing_type, andruav_message_id, message_cmd, &delta_header);
+        // a coalesced message would break the chain of deltas.
+        queueMSG(std::move(msg), andruav_message_id, target_party, msg_routing_type, false);
+        return ;
     }
-    else
+
+    serializeMessage(msg, target_party, msg_routing_type, andruav_message_id, jmsg);
+    
+    #ifdef DDEBUG
+        std::cout << "sendJMSG:" << msg.c_str() << std::endl;
+    #endif
+    queueMSG(std::move(msg), andruav_message_id, target_party, msg_routing_type);
+}
+
+
+/**
+ * @brief sends binary packet
+ * @details sends binary packet.
+ * Binary packet always has JSON header then 0 then binary data.
+ * 
+ * @param targetPartyID 
+ * @param bmsg 
+ * @param andruav_message_id 
+ * @param internal_message if true @link INTERMODULE_MODULE_KEY @endlink equaqls to Module key
+ * @param message_cmd JSON message in ms section of JSON header. if null then pass Json_de()
+ */
+void de::comm::CModule::sendBMSG (const std::string_view targetPartyID, const char * bmsg, const int bmsg_length, const int& andruav_message_id, const bool& internal_message, const Json_de& message_cmd)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+                
+    std::string msg = CBufferPool::getThreadInstance().acquire(BUFFER_POOL_MIN_SIZE + bmsg_length);
+    const PARTY_HANDLE target_party = internParty(targetPartyID);
+    const char * msg_routing_type = getRoutingType(targetPartyID, internal_message);
+    serializeMessage(msg, target_party, msg_routing_type, andruav_message_id, message_cmd);
+    appendBinaryPart(msg, bmsg, bmsg_length);
+
+    queueMSG(std::move(msg), andruav_message_id, target_party, msg_routing_type);
+
+    return ;
+}
+
+
+/**
+ * @brief appends 0 then binary part to a serialized message.
+ * @details binary part is LZ4 compressed instead if it is negotiated. see setPayloadCompression
+ * must be called while m_lock is held.
+ */
+void de::comm::CModule::appendBinaryPart (std::string& msg, const char * bmsg, const std::size_t bmsg_length) const
+{
+    // compressed before CUDPClient splits it into chunks.
+    const bool compressed = m_payload_compression_accepted
+                        && (bmsg_length >= m_payload_compression_min_size)
+                        && appendCompressedPayload(msg, bmsg, bmsg_length);
+    if (compressed) return ;
+
+    /**** Attach Binary part to String after inserting NULL ***/
+    msg.reserve(msg.length() + 1 + bmsg_length);
+    msg.push_back('\0');
+
+    // Append binary message
+    if (bmsg_length != 0)
+    {
+        msg.append(bmsg, bmsg_length);
+    }
+    /**** Attachment End ****/
+}
+
+
+/**
+ * @brief returns index of a MAVLink stream in m_mavlink_streams.
+ * @details headers are rendered on first use of a target, routing type and message type combination.
+ * must be called while m_lock is held.
+ */
+std::size_t de::comm::CModule::getMavlinkStream (const std::string_view targetPartyID, const int andruav_message_id, const bool internal_message)
+{
+    const char * msg_routing_type = getRoutingType(targetPartyID, internal_message);
+    const PARTY_HANDLE target_party = internParty(targetPartyID);
+
+    std::size_t stream_index = 0;
+    for (; stream_index < m_mavlink_streams.size(); ++stream_index)
+    {
+        const MAVLINK_STREAM& stream = m_mavlink_streams[stream_index];
+        if ((stream.andruav_message_id == andruav_message_id)
+            && (stream.routing_type == msg_routing_type)
+            && (stream.target_party == target_party))
+        {
+            break;
+        }
+    }
+
+    if (stream_index == m_mavlink_streams.size())
+    {
+        if (m_mavlink_streams.size() >= MAX_MAVLINK_HEADER_CACHE)
+        {
+            // batching streams hold configuration so they are evicted only when all streams are batching.
+            std::size_t evicted_index = 0;
+            for (std::size_t i = 1; i < m_mavlink_streams.size(); ++i)
+            {
+                const MAVLINK_STREAM& candidate = m_mavlink_streams[i];
+                const MAVLINK_STREAM& evicted = m_mavlink_streams[evicted_index];
+                if (std::make_pair(candidate.batch_window_ms != 0, candidate.last_use) < std::make_pair(evicted.batch_window_ms != 0, evicted.last_use))
+                {
+                    evicted_index = i;
+                }
+            }
+
+            flushMavlinkBatch(evicted_index);
+            m_mavlink_streams.erase(m_mavlink_streams.begin() + evicted_index);
+            ++m_mavlink_batch_counters.streams_evicted;
+            stream_index = m_mavlink_streams.size();
+        }
+
+        MAVLINK_STREAM stream;
+        stream.andruav_message_id = andruav_message_id;
+        stream.routing_type = msg_routing_type;
+        stream.target_party = target_party;
+        stream.batch_window_ms = 0;
+        stream.batch_byte_budget = 0;
+        m_mavlink_streams.push_back(std::move(stream));
+    }
+
+    MAVLINK_STREAM& stream = m_mavlink_streams[stream_index];
+    stream.last_use = ++m_mavlink_stream_uses;
+    if (stream.header.empty())
+    {
+        serializeMessage(stream.header, target_party, msg_routing_type, andruav_message_id, Json_de());
+        stream.header.push_back('\0');
+
+        Json_de batch_cmd;
+        batch_cmd[MAVLINK_BATCH_FLAG] = 1;
+        serializeMessage(stream.batch_header, target_party, msg_routing_type, andruav_message_id, batch_cmd);
+        stream.batch_header.push_back('\0');
+    }
+
+    return stream_index;
+}
+
+
+/**
+ * @brief sends queued frames of a stream as one message.
+ * @details must be called while m_lock is held.
+ */
+void de::comm::CModule::flushMavlinkBatch (const std::size_t stream_index)
+{
+    MAVLINK_STREAM& stream = m_mavlink_streams[stream_index];
+    if (stream.batch.empty()) return ;
+
+    queueMSG(stream.batch.data(), stream.batch.length(), stream.andruav_message_id, stream.target_party, stream.routing_type);
+    ++m_mavlink_batch_counters.batches_sent;
+    
+    // keep capacity for next batch.
+    stream.batch.clear();
+}
+
+
+/**
+ * @brief flushes queued frames and drops rendered headers.
+ * @details called when module key changes. must be called while m_lock is held.
+ */
+void de::comm::CModule::resetMavlinkStreams ()
+{
+    for (std::size_t stream_index = 0; stream_index < m_mavlink_streams.size(); ++stream_index)
+    {
+        flushMavlinkBatch(stream_index);
+        m_mavlink_streams[stream_index].header.clear();
+        m_mavlink_streams[stream_index].batch_header.clear();
+    }
+}
+
+
+void de::comm::CModule::sendMAVLINK (const std::string_view targetPartyID, const char * frame, const int frame_length, const int andruav_message_id, const bool internal_message)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    const std::size_t stream_index = getMavlinkStream(targetPartyID, andruav_message_id, internal_message);
+    MAVLINK_STREAM& stream = m_mavlink_streams[stream_index];
+
+    if ((stream.batch_window_ms == 0) || (frame_length > MAX_MAVLINK_BATCH_FRAME_SIZE))
+    {
+        // keep frames order.
+        flushMavlinkBatch(stream_index);
+
+        m_mavlink_buffer.assign(stream.header);
+        
+        if (frame_length != 0)
+        {
+            m_mavlink_buffer.append(frame, frame_length);
+        }
+
+        queueMSG(m_mavlink_buffer.data(), m_mavlink_buffer.length(), andruav_message_id, stream.target_party, stream.routing_type);
+        return ;
+    }
+
+    const std::size_t record_length = 2 + frame_length;
+    if (!stream.batch.empty() && (stream.batch.length() - stream.batch_header.length() + record_length > stream.batch_byte_budget))
+    {
+        flushMavlinkBatch(stream_index);
+        ++m_mavlink_batch_counters.budget_flushes;
+    }
+
+    if (stream.batch.empty())
+    {
+        stream.batch.assign(stream.batch_header);
+        stream.batch_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(stream.batch_window_ms);
+        m_mavlink_batch_cv.notify_one();
+    }
+
+    stream.batch.push_back(static_cast<char>(frame_length & 0xFF));
+    stream.batch.push_back(static_cast<char>((frame_length >> 8) & 0xFF));
+    stream.batch.append(frame, frame_length);
+    ++m_mavlink_batch_counters.frames_batched;
+
+    if (stream.batch.length() - stream.batch_header.length() >= stream.batch_byte_budget)
+    {
+        flushMavlinkBatch(stream_index);
+        ++m_mavlink_batch_counters.budget_flushes;
+    }
+}
+
+
+void de::comm::CModule::setMavlinkBatching (const std::string_view targetPartyID, const int andruav_message_id, const bool internal_message, const uint32_t window_ms, const uint32_t byte_budget)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    const std::size_t stream_index = getMavlinkStream(targetPartyID, andruav_message_id, internal_message);
+    MAVLINK_STREAM& stream = m_mavlink_streams[stream_index];
+
+    if (window_ms == 0)
+    {
+        flushMavlinkBatch(stream_index);
+    }
+    
+    stream.batch_window_ms = window_ms;
+    stream.batch_byte_budget = byte_budget;
+
+    if ((window_ms != 0) && !m_threadMavlinkBatch.joinable())
+    {
+        m_mavlink_batch_stop = false;
+        m_threadMavlinkBatch = std::thread{[&]()
+                                          { InternalMavlinkBatchEntry(); }};
+    }
+}
+
+
+/**
+ * @brief sends queued records of a value stream as one message.
+ * @details must be called while m_lock is held.
+ */
+void de::comm::CModule::flushValueStream (VALUE_STREAM& stream)
+{
+    if (stream.batch_records == 0) return ;
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    Json_de message_cmd;
+    message_cmd[VALUE_STREAM_ID] = stream.descriptor.getStreamId();
+    if (!stream.descriptor_sent || (now - stream.descriptor_time >= std::chrono::milliseconds(VALUE_STREAM_DESCRIPTOR_PERIOD_MS)))
+    {
+        message_cmd[VALUE_STREAM_DESCRIPTOR] = stream.descriptor.toJson();
+        stream.descriptor_sent = true;
+        stream.descriptor_time = now;
+        ++m_value_stream_counters.descriptors_sent;
+    }
+
+    std::string msg = CBufferPool::getThreadInstance().acquire(BUFFER_POOL_MIN_SIZE + stream.batch.length());
+    countPartyUse(stream.target_party);
+    serializeMessage(msg, stream.target_party, stream.routing_type, stream.andruav_message_id, message_cmd);
+    appendBinaryPart(msg, stream.batch.data(), stream.batch.length());
+    queueMSG(std::move(msg), stream.andruav_message_id, stream.target_party, stream.routing_type);
+
+    m_value_stream_counters.records_sent += stream.batch_records;
+    ++m_value_stream_counters.batches_sent;
+
+    // keep capacity for next batch.
+    stream.batch.clear();
+    stream.batch_records = 0;
+}
+
+
+void de::comm::CModule::defineValueStream (const std::string_view targetPartyID, const int andruav_message_id, const bool internal_message,
+                                           const CValueStreamDescriptor& descriptor, const uint32_t window_ms, const uint16_t max_records)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    const std::map<uint16_t, VALUE_STREAM>::iterator it = m_value_streams.find(descriptor.getStreamId());
+    if (it != m_value_streams.end())
+    {
+        flushValueStream(it->second);
+        m_value_streams.erase(it);
+    }
+
+    if ((max_records == 0) || (descriptor.getFieldCount() == 0)) return ;
+
+    VALUE_STREAM& stream = m_value_streams[descriptor.getStreamId()];
+    stream.descriptor = descriptor;
+    stream.andruav_message_id = andruav_message_id;
+    stream.routing_type = getRoutingType(targetPartyID, internal_message);
+    stream.target_party = addParty(targetPartyID);
+    stream.window_ms = window_ms;
+    stream.max_records = max_records;
+    stream.batch.reserve(static_cast<std::size_t>(max_records) * descriptor.getRecordSize());
+    stream.batch_records = 0;
+    stream.descriptor_sent = false;
+
+    if ((window_ms != 0) && !m_threadMavlinkBatch.joinable())
+    {
+        m_mavlink_batch_stop = false;
+        m_threadMavlinkBatch = std::thread{[&]()
+                                          { InternalMavlinkBatchEntry(); }};
+    }
+}
+
+
+bool de::comm::CModule::pushValues (const uint16_t stream_id, const double * values, const std::size_t count)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    const std::map<uint16_t, VALUE_STREAM>::iterator it = m_value_streams.find(stream_id);
+    if (it == m_value_streams.end()) return false;
+
+    VALUE_STREAM& stream = it->second;
+    if (count != stream.descriptor.getFieldCount()) return false;
+
+    if (stream.batch_records == 0)
+    {
+        stream.batch_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(stream.window_ms);
+        m_mavlink_batch_cv.notify_one();
+    }
+
+    const std::size_t offset = stream.batch.length();
+    stream.batch.resize(offset + stream.descriptor.getRecordSize());
+    stream.descriptor.pack(values, &stream.batch[offset]);
+    ++stream.batch_records;
+
+    if ((stream.window_ms == 0) || (stream.batch_records >= stream.max_records))
+    {
+        flushValueStream(stream);
+    }
+
+    return true;
+}
+
+
+VALUE_STREAM_COUNTERS de::comm::CModule::getValueStreamCounters ()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    VALUE_STREAM_COUNTERS counters = m_value_stream_counters;
+    counters.records_received = m_value_records_received;
+    counters.batches_dropped = m_value_batches_dropped;
+    return counters;
+}
+
+
+MAVLINK_BATCH_COUNTERS de::comm::CModule::getMavlinkBatchCounters ()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    MAVLINK_BATCH_COUNTERS counters = m_mavlink_batch_counters;
+    counters.batches_received = m_mavlink_batches_received;
+    counters.frames_received = m_mavlink_frames_received;
+    return counters;
+}
+
+
+/**
+ * @brief flushes batches whose window expired.
+ * @details sleeps until the nearest batch deadline or until a new batch is started.
+ */
+void de::comm::CModule::InternalMavlinkBatchEntry ()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    while (!m_mavlink_batch_stop)
+    {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::time_point next_deadline = std::chrono::steady_clock::time_point::max();
+        
+        for (std::size_t stream_index = 0; stream_index < m_mavlink_streams.size(); ++stream_index)
+        {
+            const MAVLINK_STREAM& stream = m_mavlink_streams[stream_index];
+            if (stream.batch.empty()) continue;
+
+            if (stream.batch_deadline <= now)
+            {
+                flushMavlinkBatch(stream_index);
+                ++m_mavlink_batch_counters.window_flushes;
+            }
+            else if (stream.batch_deadline < next_deadline)
+            {
+                next_deadline = stream.batch_deadline;
+            }
+        }
+
+        for (std::pair<const uint16_t, VALUE_STREAM>& entry : m_value_streams)
+        {
+            VALUE_STREAM& stream = entry.second;
+            if (stream.batch_records == 0) continue;
+
+            if (stream.batch_deadline <= now)
+            {
+                flushValueStream(stream);
+            }
+            else if (stream.batch_deadline < next_deadline)
+            {
+                next_deadline = stream.batch_deadline;
+            }
+        }
+
+        if (next_deadline == std::chrono::steady_clock::time_point::max())
+        {
+            m_mavlink_batch_cv.wait(lock);
+        }
+        else
+        {
+            m_mavlink_batch_cv.wait_until(lock, next_deadline);
+        }
+    }
+
+    for (std::size_t stream_index = 0; stream_index < m_mavlink_streams.size(); ++stream_index)
+    {
+        flushMavlinkBatch(stream_index);
+    }
+
+    for (std::pair<const uint16_t, VALUE_STREAM>& entry : m_value_streams)
+    {
+        flushValueStream(entry.second);
+    }
+}
+
+
+void de::comm::CModule::stopMavlinkBatching ()
+{
+    if (!m_threadMavlinkBatch.joinable()) return ;
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_mavlink_batch_stop = true;
+    }
+    m_mavlink_batch_cv.notify_one();
+    
+    m_threadMavlinkBatch.join();
+}
+
+
+/**
+ * @brief sends message directly or through the outbound queue if it is enabled.
+ * @details msg buffer returns to the buffer pool after it is sent.
+ * must be called while m_lock is held.
+ */
+void de::comm::CModule::queueMSG (std::string&& msg, const int andruav_message_id, const PARTY_HANDLE target_party, const char * msg_routing_type, const bool can_coalesce)
+{
+    char routing_prefix[ROUTING_PREFIX_SIZE];
+    const int routing_prefix_length = getRoutingPrefix(andruav_message_id, target_party, msg_routing_type, routing_prefix);
+
+    {
+        std::unique_lock<std::mutex> lock(m_outbound_lock);
+        waitOutboundQueueDrained(lock);
+        if (m_outbound_queue_enabled)
+        {
+            enqueueMSG(std::move(msg), andruav_message_id, target_party, getRoutingTypeCode(msg_routing_type), routing_prefix, routing_prefix_length, can_coalesce);
+            return ;
+        }
+    }
+
+    sendMSG(routing_prefix, routing_prefix_length, msg.data(), msg.length());
+    CBufferPool::getThreadInstance().release(std::move(msg));
+}
+
+
+/**
+ * @brief same as above for messages in reused buffers. msg is copied only if it is queued.
+ */
+void de::comm::CModule::queueMSG (const char * msg, const int length, const int andruav_message_id, const PARTY_HANDLE target_party, const char * msg_routing_type)
+{
+    char routing_prefix[ROUTING_PREFIX_SIZE];
+    const int routing_prefix_length = getRoutingPrefix(andruav_message_id, target_party, msg_routing_type, routing_prefix);
+
+    {
+        std::unique_lock<std::mutex> lock(m_outbound_lock);
+        waitOutboundQueueDrained(lock);
+        if (m_outbound_queue_enabled)
+        {
+            std::string buffer = CBufferPool::getThreadInstance().acquire(length);
+            buffer.assign(msg, length);
+            enqueueMSG(std::move(buffer), andruav_message_id, target_party, getRoutingTypeCode(msg_routing_type), routing_prefix, routing_prefix_length);
+            return ;
+        }
+    }
+
+    sendMSG(routing_prefix, routing_prefix_length, msg, length);
+}
+
+
+/**
+ * @brief writes routing prefix of an outgoing message if the communicator accepted it.
+ * @details must be called while m_lock is held.
+ * @return prefix length. zero if message is sent without prefix.
+ */
+int de::comm::CModule::getRoutingPrefix (const int andruav_message_id, const PARTY_HANDLE target_party, const char * msg_routing_type, char * routing_prefix) const
+{
+    if (!m_routing_prefix_accepted) return 0;
+
+    ROUTING_PREFIX prefix;
+    if (!makeRoutingPrefix(andruav_message_id, msg_routing_type, target_party != 0, m_party_table.getAlias(target_party), prefix)) return 0;
+
+    writeRoutingPrefix(prefix, routing_prefix);
+    return ROUTING_PREFIX_SIZE;
+}
+
+
+/**
+ * @brief while the outbound queue is being stopped, waits until its remaining messages are sent.
+ * @details new messages are then sent directly and never overtake queued ones.
+ * Messages that arrive while stopping are not queued, so stopping ends.
+ */
+void de::comm::CModule::waitOutboundQueueDrained (std::unique_lock<std::mutex>& lock)
+{
+    m_outbound_drained_cv.wait(lock, [this]() { return !m_outbound_queue_enabled || !m_outbound_queue_stop; });
+}
+
+
+/**
+ * @brief adds message to outbound queue or replaces a queued older instance.
+ * @details oldest messages are dropped while the queue is full.
+ * must be called while m_outbound_lock is held.
+ */
+void de::comm::CModule::enqueueMSG (std::string&& msg, const int andruav_message_id, const PARTY_HANDLE target_party, const ENUM_ROUTING_TYPE routing_type,
+                                    const char * routing_prefix, const int routing_prefix_length, const bool can_coalesce)
+{
+    // a buffer of a sent message goes back to the pool of the thread that serializes messages.
+    // one per queued message matches the one acquired for it and does not overflow the pool.
+    CBufferPool& buffer_pool = CBufferPool::getThreadInstance();
+    if (!m_outbound_free_buffers.empty())
+    {
+        buffer_pool.release(std::move(m_outbound_free_buffers.back()));
+        m_outbound_free_buffers.pop_back();
+    }
+
+    const bool is_coalescable = can_coalesce && isMessageCoalescable(andruav_message_id);
+
+    bool has_deadline = false;
+    std::chrono::steady_clock::time_point deadline;
+    const auto deadline_ms = m_outbound_deadlines.find(andruav_message_id);
+    if (deadline_ms != m_outbound_deadlines.end())
+    {
+        has_deadline = true;
+        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(deadline_ms->second);
+    }
+
+    if (is_coalescable)
+    {
+        for (OUTBOUND_MESSAGE& queued_message : m_outbound_queue)
+        {
+            if ((queued_message.andruav_message_id == andruav_message_id)
+                && (queued_message.target_party == target_party)
+                && (queued_message.routing_type == routing_type))
+            {
+                // newer value takes the place of the older one so it is not delayed further.
+                m_outbound_queue_bytes += msg.length() - queued_message.message.length();
+                queued_message.message.swap(msg);
+                buffer_pool.release(std::move(msg));
+                std::memcpy(queued_message.routing_prefix, routing_prefix, routing_prefix_length);
+                queued_message.routing_prefix_length = routing_prefix_length;
+                queued_message.has_deadline = has_deadline;
+                queued_message.deadline = deadline;
+                ++m_outbound_counters[andruav_message_id].coalesced;
+                return ;
+            }
+        }
+    }
+
+    while (!m_outbound_queue.empty()
+           && ((m_outbound_queue.size() >= m_outbound_max_messages) || (m_outbound_queue_bytes + msg.length() > m_outbound_max_bytes)))
+    {
+        OUTBOUND_MESSAGE& oldest_message = m_outbound_queue.front();
+        ++m_outbound_counters[oldest_message.andruav_message_id].dropped;
+        m_outbound_queue_bytes -= oldest_message.message.length();
+        buffer_pool.release(std::move(oldest_message.message));
+        m_outbound_queue.pop_front();
+    }
+
+    OUTBOUND_MESSAGE outbound_message;
+    outbound_message.andruav_message_id = andruav_message_id;
+    outbound_message.has_deadline = has_deadline;
+    outbound_message.deadline = deadline;
+    outbound_message.target_party = target_party;
+    outbound_message.routing_type = routing_type;
+    std::memcpy(outbound_message.routing_prefix, routing_prefix, routing_prefix_length);
+    outbound_message.routing_prefix_length = routing_prefix_length;
+    outbound_message.message = std::move(msg);
+    m_outbound_queue_bytes += outbound_message.message.length();
+    m_outbound_queue.push_back(std::move(outbound_message));
+
+    m_outbound_cv.notify_one();
+}
+
+
+void de::comm::CModule::setOutboundQueue (const bool enabled, const std::size_t max_messages, const std::size_t max_bytes)
+{
+    if (!enabled)
+    {
+        stopOutboundQueue();
+        return ;
+    }
+
+    std::lock_guard<std::mutex> lock(m_outbound_lock);
+    m_outbound_max_messages = std::max<std::size_t>(max_messages, 1);
+    m_outbound_max_bytes = max_bytes;
+    if (m_outbound_queue_enabled) return ;
+
+    m_outbound_queue_enabled = true;
+    m_outbound_queue_stop = false;
+    m_threadOutboundQueue = std::thread{[&]()
+                                       { InternalOutboundQueueEntry(); }};
+}
+
+
+void de::comm::CModule::setFieldPrecision (const int andruav_message_id, const std::string& field, const int decimal_places)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (decimal_places < 0)
+    {
+        const std::map<int, JSON_FIELD_PRECISION>::iterator precision = m_field_precision.find(andruav_message_id);
+        if (precision == m_field_precision.end()) return ;
+
+        precision->second.erase(field);
+        if (precision->second.empty()) m_field_precision.erase(precision);
+    }
+    else
+    {
+        m_field_precision[andruav_message_id][field] = decimal_places;
+    }
+}
+
+
+void de::comm::CModule::setWireEncoding (const ENUM_DATABUS_ENCODING encoding)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    m_offered_encoding = encoding;
+    if (m_wire_encoding != encoding)
+    {
+        // wait for the communicator to accept the new offer.
+        m_wire_encoding = DATABUS_ENCODING_JSON;
+        resetMavlinkStreams();
+    }
+}
+
+
+ENUM_DATABUS_ENCODING de::comm::CModule::getWireEncoding ()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    return m_wire_encoding;
+}
+
+
+bool de::comm::CModule::setDictionaryCompression (const std::string& dictionary, const std::size_t min_size)
+{
+    std::shared_ptr<CDictionaryCodec> codec;
+    if (!dictionary.empty())
+    {
+        codec = std::make_shared<CDictionaryCodec>();
+        if (!codec->load(dictionary)) return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    std::atomic_store(&m_dictionary_codec, std::shared_ptr<const CDictionaryCodec>(codec));
+    m_dictionary_min_size = min_size;
+    // wait for the communicator to accept the new dictionary.
+    m_dictionary_accepted = false;
+    resetMavlinkStreams();
+    
+    return true;
+}
+
+
+bool de::comm::CModule::setPayloadCompression (const bool enabled, const std::size_t min_size)
+{
+#ifndef DE_ENABLE_LZ4
+    if (enabled) return false;
+#endif
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    m_payload_compression_offered = enabled;
+    m_payload_compression_min_size = min_size;
+    // wait for the communicator to accept the offer.
+    m_payload_compression_accepted = false;
+
+    return true;
+}
+
+
+void de::comm::CModule::setDeltaEncoding (const int andruav_message_id, const uint32_t keyframe_interval, const uint32_t keyframe_period_ms, const ENUM_DELTA_REFERENCE reference)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (keyframe_interval == 0)
+    {
+        m_delta_config.erase(andruav_message_id);
+    }
+    else
+    {
+        m_delta_config[andruav_message_id] = DELTA_ENCODING_CONFIG{keyframe_interval, keyframe_period_ms, reference};
+    }
+
+    // streams restart with a keyframe using the new settings.
+    m_delta_encoder.reset();
+}
+
+
+DELTA_ENCODING_COUNTERS de::comm::CModule::getDeltaEncodingCounters ()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    DELTA_ENCODING_COUNTERS counters;
+    counters.keyframes_sent = m_delta_encoder.getKeyframesSent();
+    counters.deltas_sent = m_delta_encoder.getDeltasSent();
+    counters.deltas_rebuilt = m_delta_decoder.getDeltasRebuilt();
+    counters.deltas_dropped = m_delta_decoder.getDeltasDropped();
+    return counters;
+}
+
+
+void de::comm::CModule::setSessionAliases (const bool enabled, const uint32_t min_uses)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    m_session_aliases_offered = enabled;
+    m_session_alias_min_uses = min_uses;
+    if (enabled) return ;
+
+    const bool had_aliases = m_party_table.clearAliases() || (m_module_key_alias != 0);
+    m_module_key_alias = 0;
+    if (had_aliases) resetMavlinkStreams();
+}
+
+
+void de::comm::CModule::setRoutingPrefix (const bool enabled)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    m_routing_prefix_offered = enabled;
+    // wait for the communicator to accept the new offer.
+    if (!enabled) m_routing_prefix_accepted = false;
+}
+
+
+bool de::comm::CModule::setMessageHandler (const int message_type, MessageHandler handler)
+{
+    if (cUDPClient.isStarted())
+    {
+        std::cout << _ERROR_CONSOLE_BOLD_TEXT_ << "setMessageHandler(" << message_type << ") is ignored after init()" << _NORMAL_CONSOLE_TEXT_ << std::endl;
+        return false;
+    }
+
+    m_message_handlers.setHandler(message_type, std::move(handler));
+    return true;
+}
+
+
+bool de::comm::CModule::removeMessageHandler (const int message_type)
+{
+    if (cUDPClient.isStarted())
+    {
+        std::cout << _ERROR_CONSOLE_BOLD_TEXT_ << "removeMessageHandler(" << message_type << ") is ignored after init()" << _NORMAL_CONSOLE_TEXT_ << std::endl;
+        return false;
+    }
+
+    m_message_handlers.removeHandler(message_type);
+    return true;
+}
+
+
+void de::comm::CModule::setBinaryTelemetry (const bool enabled)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    m_binary_telemetry_offered = enabled;
+    // wait for the communicator to answer the new offer.
+    if (enabled) return ;
+
+    m_binary_telemetry_accepted_all = false;
+    m_binary_telemetry_parties.clear();
+}
+
+
+/**
+ * @brief true if the communicator reported that targetPartyID decodes binary telemetry. see setBinaryTelemetry
+ */
+bool de::comm::CModule::isBinaryTelemetryAccepted (const std::string_view targetPartyID)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (m_binary_telemetry_accepted_all) return true;
+    return (!targetPartyID.empty()) && (m_binary_telemetry_parties.find(targetPartyID) != m_binary_telemetry_parties.end());
+}
+
+
+/**
+ * @brief interns a party id. When the table is full, parties not held by a stream or a queued message are evicted first.
+ * @details must be called while m_lock is held.
+ */
+PARTY_HANDLE de::comm::CModule::addParty (const std::string_view party_id)
+{
+    if (m_party_table.isFull())
+    {
+        std::set<PARTY_HANDLE> referenced;
+        for (const MAVLINK_STREAM& stream : m_mavlink_streams) referenced.insert(stream.target_party);
+        for (const std::pair<const uint16_t, VALUE_STREAM>& stream : m_value_streams) referenced.insert(stream.second.target_party);
+        {
+            // a reused handle would let a new party coalesce with a queued message of an evicted one.
+            std::lock_guard<std::mutex> outbound_lock(m_outbound_lock);
+            for (const OUTBOUND_MESSAGE& queued_message : m_outbound_queue) referenced.insert(queued_message.target_party);
+        }
+
+        for (const PARTY_HANDLE party : m_party_table.evict(referenced)) m_delta_encoder.removeParty(party);
+    }
+
+    return m_party_table.intern(party_id);
+}
+
+
+/**
+ * @brief interns target party id of an outgoing message and counts its use.
+ * @details must be called while m_lock is held.
+ */
+PARTY_HANDLE de::comm::CModule::internParty (const std::string_view targetPartyID)
+{
+    const PARTY_HANDLE target_party = addParty(targetPartyID);
+    countPartyUse(target_party);
+    return target_party;
+}
+
+
+/**
+ * @brief asks the communicator for an alias of a party once it is used often enough.
+ * @details ID message is recreated with the party offered and resend flag set so the communicator replies.
+ * must be called while m_lock is held.
+ */
+void de::comm::CModule::countPartyUse (const PARTY_HANDLE target_party)
+{
+    if (!m_session_aliases_offered) return ;
+    if (!m_party_table.countUse(target_party, m_session_alias_min_uses)) return ;
+
+    m_session_aliases_requested = true;
+    createJSONID(true);
+}
+
+
+void de::comm::CModule::setOutboundDeadline (const int andruav_message_id, const uint32_t deadline_ms)
+{
+    std::lock_guard<std::mutex> lock(m_outbound_lock);
+
+    if (deadline_ms == 0)
+    {
+        m_outbound_deadlines.erase(andruav_message_id);
+    }
+    else
+    {
+        m_outbound_deadlines[andruav_message_id] = deadline_ms;
+    }
+}
+
+
+std::map<int, OUTBOUND_MESSAGE_COUNTERS> de::comm::CModule::getOutboundQueueCounters ()
+{
+    std::lock_guard<std::mutex> lock(m_outbound_lock);
+    return m_outbound_counters;
+}
+
+
+/**
+ * @brief sends queued messages in order.
+ * @details sending happens outside m_outbound_lock so senders can keep coalescing
+ * while a slow send is in progress. Remaining messages are sent when queue is stopped.
+ * Senders wait until the queue is empty before sending directly, so they never overtake queued messages.
+ */
+void de::comm::CModule::InternalOutboundQueueEntry ()
+{
+    std::unique_lock<std::mutex> lock(m_outbound_lock);
+
+    while (true)
+    {
+        m_outbound_cv.wait(lock, [this]() { return m_outbound_queue_stop || !m_outbound_queue.empty(); });
+        if (m_outbound_queue.empty())
+        {
+            // drained. new messages are sent directly from now on.
+            m_outbound_queue_enabled = false;
+            m_outbound_drained_cv.notify_all();
+            break;
+        }
+
+        OUTBOUND_MESSAGE outbound_message = std::move(m_outbound_queue.front());
+        m_outbound_queue.pop_front();
+        m_outbound_queue_bytes -= outbound_message.message.length();
+
+        if (outbound_message.has_deadline && (outbound_message.deadline < std::chrono::steady_clock::now()))
+        {
+            ++m_outbound_counters[outbound_message.andruav_message_id].expired;
+            recycleOutboundBuffer(std::move(outbound_message.message));
+            continue;
+        }
+
+        lock.unlock();
+        sendMSG(outbound_message.routing_prefix, outbound_message.routing_prefix_length, outbound_message.message.data(), outbound_message.message.length());
+        lock.lock();
+        recycleOutboundBuffer(std::move(outbound_message.message));
+    }
+}
+
+
+/**
+ * @brief keeps buffer of a sent or expired message until the next enqueueMSG.
+ * @details CBufferPool is thread local, so releasing here would fill the pool of the queue thread
+ * that never acquires. enqueueMSG releases them into the pool of the sending thread instead.
+ * must be called while m_outbound_lock is held.
+ */
+void de::comm::CModule::recycleOutboundBuffer (std::string&& buffer)
+{
+    if (m_outbound_free_buffers.size() >= OUTBOUND_QUEUE_FREE_BUFFERS) return ;
+    m_outbound_free_buffers.push_back(std::move(buffer));
+}
+
+
+void de::comm::CModule::stopOutboundQueue ()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_outbound_lock);
+        // queue thread disables the queue once remaining messages are sent.
+        m_outbound_queue_stop = true;
+    }
+    m_outbound_cv.notify_one();
+
+    if (m_threadOutboundQueue.joinable())
     {
-        if (targetPartyID.length() != 0 )
-        {
-            msg_routing_type = CMD_COMM_INDIVIDUAL;
-        }
+        m_threadOutboundQueue.join();
     }
-        
-    fullMessage[INTERMODULE_MODULE_KEY]             = m_module_key;
-    fullMessage[ANDRUAV_PROTOCOL_TARGET_ID]         = targetPartyID; // targetID can exist even if routing is intermodule
-    fullMessage[INTERMODULE_ROUTING_TYPE]           = std::string(msg_routing_type);
-    fullMessage[ANDRUAV_PROTOCOL_MESSAGE_TYPE]      = andruav_message_id;
-    fullMessage[ANDRUAV_PROTOCOL_MESSAGE_CMD]       = jmsg;
-    const std::string& msg = fullMessage.dump();
-    #ifdef DDEBUG
-        std::cout << "sendJMSG:" << msg.c_str() << std::endl;
-    #endif
-    sendMSG(msg.c_str(), msg.length());
 }
 
 
-/**
- * @brief sends binary packet
- * @details sends binary packet.
- * Binary packet always has JSON header then 0 then binary data.
- * 
- * @param targetPartyID 
- * @param bmsg 
- * @param andruav_message_id 
- * @param internal_message if true @link INTERMODULE_MODULE_KEY @endlink equaqls to Module key
- * @param message_cmd JSON message in ms section of JSON header. if null then pass Json_de()
- */
-void de::comm::CModule::sendBMSG (const std::string& targetPartyID, const char * bmsg, const int bmsg_length, const int& andruav_message_id, const bool& internal_message, const Json_de& message_cmd)
+void de::comm::CModule::subscribe (const std::vector<int>& message_types)
 {
     std::lock_guard<std::mutex> lock(m_lock);
-                
-    Json_de fullMessage;
 
-    std::string msg_routing_type = CMD_COMM_GROUP;
-    if (internal_message == true)
-    {
-        msg_routing_type = CMD_TYPE_INTERMODULE;
-        
-    }
-    else
+    if (!m_message_filter.is_array()) m_message_filter = Json_de::array();
+
+    Json_de subscribed = Json_de::array();
+    for (const int message_type : message_types)
     {
-        if (targetPartyID.length() != 0 )
-        {
-                    
-            msg_routing_type = CMD_COMM_INDIVIDUAL;
-        }
-        
+        if (std::find(m_message_filter.begin(), m_message_filter.end(), message_type) != m_message_filter.end()) continue;
+        m_message_filter.push_back(message_type);
+        subscribed.push_back(message_type);
     }
-        
-    fullMessage[INTERMODULE_MODULE_KEY]             = m_module_key;    
-    fullMessage[ANDRUAV_PROTOCOL_TARGET_ID]         = targetPartyID; // targetID can exist even if routing is intermodule
-    fullMessage[INTERMODULE_ROUTING_TYPE]           = std::string(msg_routing_type);
-    fullMessage[ANDRUAV_PROTOCOL_MESSAGE_TYPE]      = andruav_message_id;
-    fullMessage[ANDRUAV_PROTOCOL_MESSAGE_CMD]       = message_cmd;
 
-    std::string json_msg = fullMessage.dump();
-    
-    /**** Attach Binary part to String after inserting NULL ***/
+    if (subscribed.empty()) return ;
 
-    // Prepare a vector for the whole message
-    std::vector<char> msg(json_msg.begin(), json_msg.end());
-    msg.push_back('\0'); // Add null terminator
+    m_message_prefilter.setMessageTypes(m_message_filter);
+    sendSubscriptionDelta(subscribed, Json_de::array());
+}
 
-    // Append binary message
-    if (bmsg_length != 0)
+
+void de::comm::CModule::unsubscribe (const std::vector<int>& message_types)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (!m_message_filter.is_array()) return ;
+
+    Json_de unsubscribed = Json_de::array();
+    for (const int message_type : message_types)
     {
-        msg.insert(msg.end(), bmsg, bmsg + bmsg_length);
+        const Json_de::iterator it = std::find(m_message_filter.begin(), m_message_filter.end(), message_type);
+        if (it == m_message_filter.end()) continue;
+        m_message_filter.erase(it);
+        unsubscribed.push_back(message_type);
     }
 
-    // Access the complete message as a char array
-    char* msg_ptr = msg.data();
+    if (unsubscribed.empty()) return ;
 
-    /**** Attachment End ****/
+    m_message_prefilter.setMessageTypes(m_message_filter);
+    sendSubscriptionDelta(Json_de::array(), unsubscribed);
+}
 
 
-    sendMSG(msg_ptr, json_msg.length()+1+bmsg_length);
+/**
+ * @brief tells the communicator which message types were added to or removed from m_message_filter.
+ * @details 'i': subscribed types, 'o': unsubscribed types.
+ * The ID message is recreated as well so communicators that missed or do not know
+ * TYPE_AndruavModule_Subscription get the whole list.
+ * must be called while m_lock is held.
+ */
+void de::comm::CModule::sendSubscriptionDelta (const Json_de& subscribed, const Json_de& unsubscribed)
+{
+    Json_de json_msg;
 
-    return ;
+    json_msg[INTERMODULE_MODULE_KEY]        = m_module_key;
+    json_msg[INTERMODULE_ROUTING_TYPE]      = CMD_TYPE_INTERMODULE;
+    json_msg[ANDRUAV_PROTOCOL_MESSAGE_TYPE] = TYPE_AndruavModule_Subscription;
+
+    Json_de ms;
+    ms[JSON_INTERMODULE_SUBSCRIBED]         = subscribed;
+    ms[JSON_INTERMODULE_UNSUBSCRIBED]       = unsubscribed;
+    json_msg[ANDRUAV_PROTOCOL_MESSAGE_CMD]  = ms;
+
+    queueMSG(json_msg.dump(), TYPE_AndruavModule_Subscription, m_party_table.intern(std::string_view()), CMD_TYPE_INTERMODULE);
+
+    createJSONID(m_id_resend);
 }
 
 
@@ -197,14 +1245,16 @@ void de::comm::CModule::sendMREMSG(const int& command_type)
     json_msg[ANDRUAV_PROTOCOL_MESSAGE_CMD]          = ms;
     
     
-    const std::string msg = json_msg.dump();
-    sendMSG(msg.c_str(), msg.length());         
+    queueMSG(json_msg.dump(), TYPE_AndruavModule_RemoteExecute, m_party_table.intern(std::string_view()), CMD_TYPE_INTERMODULE);
 }
 
 
 /**
  * @brief forward a message received from another channel.
  * example: P@P module receives a messages from telemetry and wants to forward it on DE databus.
+ * Message is sent as is and never transcoded. JSON text is accepted by every receiver whatever
+ * wire encoding is negotiated, and encoded frames are recognized by their marker byte.
+ * Frames received by this module are already JSON when handlers see them. see onReceive
  * 
  * @param message 
  * @param datalength 
@@ -226,48 +1276,169 @@ void de::comm::CModule::onReceive (const char * message, int len)
     try
     {
 #endif        
-        /* code */
-        Json_de jMsg = Json_de::parse(message);
-        
-        #ifdef DDEBUG
-        std::cout << _INFO_CONSOLE_TEXT << "RX MSG: jMsg" << jMsg.dump() <<   _NORMAL_CONSOLE_TEXT_ << std::endl;
-        #endif
+        if (!m_message_prefilter.accept(message, len)) return ;
+
+        ROUTING_PREFIX routing_prefix;
+        const bool has_routing_prefix = hasRoutingPrefix(message, len);
+        if (has_routing_prefix)
+        {
+            if (!readRoutingPrefix(message, len, routing_prefix))
+            {
+                std::cout << "ERROR:" << "unknown routing prefix version" << std::endl ;
+                return ;
+            }
+            message += ROUTING_PREFIX_SIZE;
+            len -= ROUTING_PREFIX_SIZE;
+        }
+
+        Json_de decoded_json;
+        if (isEncodedFrame(message, len))
+        {
+            // transcoded once here so everything after this point handles JSON text only.
+            static thread_local std::string decoded_frame;
+            const std::shared_ptr<const CDictionaryCodec> codec = std::atomic_load(&m_dictionary_codec);
+            if (!decodeFrame(message, len, decoded_frame, &decoded_json, codec.get()))
+            {
+                std::cout << "ERROR:" << "malformed encoded frame" << std::endl ;
+                return ;
+            }
+            message = decoded_frame.data();
+            len = static_cast<int>(decoded_frame.length());
+        }
+
+        CInboundMessage inbound_message(message, len, getInboundArena(), m_inbound_parser);
+        if (!decoded_json.is_null()) inbound_message.setJson(std::move(decoded_json));
+        if (has_routing_prefix) inbound_message.setRoutingPrefix(routing_prefix);
+        const CMessageEnvelope& envelope = inbound_message.getEnvelope();
+
+        if (!envelope.isValid())
+        {
+            std::cout << "ERROR:" << "malformed message envelope" << std::endl ;
+            return ;
+        }
 
-        if (!jMsg.contains(ANDRUAV_PROTOCOL_MESSAGE_TYPE)) return ;
+        if (!envelope.hasMessageType()) return ;
         
-        if (!jMsg.contains(INTERMODULE_ROUTING_TYPE)) return ;
+        if (!envelope.hasRoutingType()) return ;
         
+        if (envelope.hasDeltaHeader() && !rebuildDeltaMessage(inbound_message)) return ;
         
-        if (std::strcmp(jMsg[INTERMODULE_ROUTING_TYPE].get<std::string>().c_str(),CMD_TYPE_INTERMODULE)==0)
+        if (envelope.getRoutingType() == CMD_TYPE_INTERMODULE)
         {
-            if (!jMsg.contains(ANDRUAV_PROTOCOL_MESSAGE_CMD)) return ;
-            
-            const Json_de cmd = jMsg[ANDRUAV_PROTOCOL_MESSAGE_CMD];
+            if (!envelope.hasCmd()) return ;
             
-
-            const int messageType = jMsg[ANDRUAV_PROTOCOL_MESSAGE_TYPE].get<int>();
+            const int messageType = envelope.getMessageType();
             switch (messageType)
             {
             case TYPE_AndruavModule_ID:
                 {
+                    const Json_de& cmd = inbound_message.getCmd();
                     if (!cmd.contains(JSON_INTERMODULE_PARTY_RECORD)) return ;
                     
-                    const Json_de unit_ids = cmd [JSON_INTERMODULE_PARTY_RECORD];
+                    const Json_de& unit_ids = cmd [JSON_INTERMODULE_PARTY_RECORD];
                     if (!unit_ids.contains(ANDRUAV_PROTOCOL_SENDER)) return ;
                     if (!unit_ids.contains(ANDRUAV_PROTOCOL_GROUP_ID)) return ;
             
                     m_party_id = std::string(unit_ids[ANDRUAV_PROTOCOL_SENDER].get<std::string>());
                     m_group_id = std::string(unit_ids[ANDRUAV_PROTOCOL_GROUP_ID].get<std::string>());
+
+                    {
+                        // communicator accepts our encoding by echoing its name. Old communicators do not answer.
+                        ENUM_DATABUS_ENCODING accepted_encoding = DATABUS_ENCODING_JSON;
+                        if (cmd.contains(JSON_INTERMODULE_WIRE_ENCODING) && cmd[JSON_INTERMODULE_WIRE_ENCODING].is_string())
+                        {
+                            accepted_encoding = getEncodingByName(cmd[JSON_INTERMODULE_WIRE_ENCODING].get<std::string>());
+                        }
+
+                        // same for the dictionary id.
+                        uint32_t accepted_dictionary_id = 0;
+                        if (cmd.contains(JSON_INTERMODULE_DICTIONARY_ID) && cmd[JSON_INTERMODULE_DICTIONARY_ID].is_number_unsigned())
+                        {
+                            accepted_dictionary_id = cmd[JSON_INTERMODULE_DICTIONARY_ID].get<uint32_t>();
+                        }
+
+                        // and for payload compression.
+                        const bool payload_compression_accepted = cmd.contains(JSON_INTERMODULE_PAYLOAD_COMPRESSION)
+                                                                && (cmd[JSON_INTERMODULE_PAYLOAD_COMPRESSION] == DATABUS_PAYLOAD_COMPRESSION_NAME_LZ4);
+
+                        // and for delta encoding.
+                        const bool delta_accepted = cmd.contains(JSON_INTERMODULE_DELTA_ENCODING)
+                                                  && (cmd[JSON_INTERMODULE_DELTA_ENCODING] == true);
+
+                        // and for routing prefix version.
+                        const bool routing_prefix_accepted = cmd.contains(JSON_INTERMODULE_ROUTING_PREFIX)
+                                                           && (cmd[JSON_INTERMODULE_ROUTING_PREFIX] == ROUTING_PREFIX_VERSION);
+
+                        // binary telemetry is answered with true for all parties or with the party ids that decode it.
+                        const Json_de::const_iterator binary_telemetry = cmd.find(JSON_INTERMODULE_BINARY_TELEMETRY);
+                        const bool binary_telemetry_answered = (binary_telemetry != cmd.end());
+
+                        std::lock_guard<std::mutex> lock(m_lock);
+                        m_payload_compression_accepted = m_payload_compression_offered && payload_compression_accepted;
+                        m_routing_prefix_accepted = m_routing_prefix_offered && routing_prefix_accepted;
+                        m_binary_telemetry_accepted_all = m_binary_telemetry_offered && binary_telemetry_answered && (*binary_telemetry == true);
+                        m_binary_telemetry_parties.clear();
+                        if (m_binary_telemetry_offered && binary_telemetry_answered && binary_telemetry->is_array())
+                        {
+                            for (const Json_de& party_id : *binary_telemetry)
+                            {
+                                if (party_id.is_string()) m_binary_telemetry_parties.insert(party_id.get<std::string>());
+                            }
+                        }
+                        if (delta_accepted != m_delta_accepted)
+                        {
+                            m_delta_accepted = delta_accepted;
+                            m_delta_encoder.reset();
+                        }
+
+                        // session aliases are assigned as {"GU": alias, "tg": {"party id": alias}}. A reply without them drops them.
+                        uint16_t module_key_alias = 0;
+                        bool aliases_changed = false;
+                        if (m_session_aliases_offered && cmd.contains(JSON_INTERMODULE_SESSION_ALIASES))
+                        {
+                            const Json_de& aliases = cmd[JSON_INTERMODULE_SESSION_ALIASES];
+                            if (aliases.contains(INTERMODULE_MODULE_KEY) && aliases[INTERMODULE_MODULE_KEY].is_number_unsigned()
+                                && (aliases[INTERMODULE_MODULE_KEY].get<uint64_t>() <= 0xFFFF))
+                            {
+                                module_key_alias = aliases[INTERMODULE_MODULE_KEY].get<uint16_t>();
+                            }
+                            aliases_changed = aliases.contains(ANDRUAV_PROTOCOL_TARGET_ID) ? m_party_table.setAliases(aliases[ANDRUAV_PROTOCOL_TARGET_ID])
+                                                                                           : m_party_table.clearAliases();
+                        }
+                        else
+                        {
+                            aliases_changed = m_party_table.clearAliases();
+                        }
+                        aliases_changed |= (module_key_alias != m_module_key_alias);
+                        m_module_key_alias = module_key_alias;
+                        if (m_session_aliases_requested && bFirstReceived)
+                        {
+                            // answer received. stop asking for it.
+                            m_session_aliases_requested = false;
+                            createJSONID(false);
+                        }
+
+                        if (accepted_encoding != m_offered_encoding) accepted_encoding = DATABUS_ENCODING_JSON;
+                        const bool dictionary_accepted = (m_dictionary_codec != nullptr) && (accepted_dictionary_id == m_dictionary_codec->getDictionaryId());
+                        if ((accepted_encoding != m_wire_encoding) || (dictionary_accepted != m_dictionary_accepted) || aliases_changed)
+                        {
+                            m_wire_encoding = accepted_encoding;
+                            m_dictionary_accepted = dictionary_accepted;
+                            resetMavlinkStreams();
+                        }
+                    }
                     
                     if (!bFirstReceived)
                     { 
                         // tell server you dont need to send ID again.
                         std::cout << _SUCCESS_CONSOLE_BOLD_TEXT_ << " ** Communicator Server Found" << _SUCCESS_CONSOLE_TEXT_ << ": m_party_id(" << _INFO_CONSOLE_TEXT << m_party_id << _SUCCESS_CONSOLE_TEXT_ << ") m_group_id(" << _INFO_CONSOLE_TEXT << m_group_id << _SUCCESS_CONSOLE_TEXT_ << ")" <<  _NORMAL_CONSOLE_TEXT_ << std::endl;
+                        std::lock_guard<std::mutex> lock(m_lock);
+                        m_session_aliases_requested = false;
                         createJSONID(false);
                         bFirstReceived = true;
                     }
                     
-                    if (m_OnReceive!= nullptr) m_OnReceive(message, len, jMsg);
+                    deliverMessage(inbound_message);
 
                     return ;
                 }
@@ -289,7 +1460,7 @@ void de::comm::CModule::onReceive (const char * message, int len)
             
         }
 
-        if (m_OnReceive!= nullptr) m_OnReceive(message, len, jMsg);
+        deliverMessage(inbound_message);
 #ifndef DE_DISABLE_TRY
     }
     catch(const std::exception& e)
@@ -300,8 +1471,386 @@ void de::comm::CModule::onReceive (const char * message, int len)
 }
 
 
+/**
+ * @brief hands a received message to the application directly or through the inbound mailbox.
+ */
+void de::comm::CModule::deliverMessage (CInboundMessage& inbound_message)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_inbound_lock);
+        if (m_inbound_mailbox_enabled)
+        {
+            const int andruav_message_id = inbound_message.getEnvelope().getMessageType();
+            const std::string_view sender = inbound_message.getEnvelope().getSender();
+            const std::size_t length = inbound_message.getLength();
+
+            INBOUND_MESSAGE mailbox_message;
+            if (isMessageCoalescable(andruav_message_id))
+            {
+                for (std::deque<INBOUND_MESSAGE>::iterator it = m_inbound_mailbox.begin(); it != m_inbound_mailbox.end(); ++it)
+                {
+                    if ((it->andruav_message_id == andruav_message_id)
+                        && (it->sender == sender))
+                    {
+                        // newer value is appended so it is not delivered before messages that arrived ahead of it.
+                        // its buffers are reused.
+                        mailbox_message = std::move(*it);
+                        m_inbound_mailbox_bytes -= mailbox_message.message.length();
+                        m_inbound_mailbox.erase(it);
+                        ++m_inbound_counters[andruav_message_id].superseded;
+                        break;
+                    }
+                }
+            }
+
+            // only state messages are dropped to make room. Commands are never dropped,
+            // so the limits are exceeded while nothing but commands wait.
+            while ((m_inbound_mailbox.size() >= m_inbound_max_messages) || (m_inbound_mailbox_bytes + length > m_inbound_max_bytes))
+            {
+                const std::deque<INBOUND_MESSAGE>::iterator oldest_state = std::find_if(m_inbound_mailbox.begin(), m_inbound_mailbox.end(),
+                    [](const INBOUND_MESSAGE& waiting_message) { return isMessageCoalescable(waiting_message.andruav_message_id); });
+                if (oldest_state == m_inbound_mailbox.end()) break;
+
+                ++m_inbound_counters[oldest_state->andruav_message_id].dropped;
+                m_inbound_mailbox_bytes -= oldest_state->message.length();
+                m_inbound_mailbox.erase(oldest_state);
+            }
+
+            mailbox_message.andruav_message_id = andruav_message_id;
+            mailbox_message.sender.assign(sender.data(), sender.length());
+            mailbox_message.message.assign(inbound_message.getMessage(), length);
+            mailbox_message.has_routing_prefix = inbound_message.hasRoutingPrefix();
+            mailbox_message.routing_prefix = inbound_message.getRoutingPrefix();
+            m_inbound_mailbox_bytes += length;
+            m_inbound_mailbox.push_back(std::move(mailbox_message));
+            
+            m_inbound_cv.notify_one();
+            return ;
+        }
+    }
+
+    dispatchInboundMessage(inbound_message);
+}
+
+
+void de::comm::CModule::setInboundMailbox (const bool enabled, const std::size_t max_messages, const std::size_t max_bytes)
+{
+    if (!enabled)
+    {
+        stopInboundMailbox();
+        return ;
+    }
+
+    std::lock_guard<std::mutex> lock(m_inbound_lock);
+    m_inbound_max_messages = std::max<std::size_t>(max_messages, 1);
+    m_inbound_max_bytes = max_bytes;
+    if (m_inbound_mailbox_enabled) return ;
+
+    m_inbound_mailbox_enabled = true;
+    m_inbound_mailbox_stop = false;
+    m_threadInboundMailbox = std::thread{[&]()
+                                        { InternalInboundMailboxEntry(); }};
+}
+
+
+std::map<int, INBOUND_MESSAGE_COUNTERS> de::comm::CModule::getInboundMailboxCounters ()
+{
+    std::lock_guard<std::mutex> lock(m_inbound_lock);
+    return m_inbound_counters;
+}
+
+
+/**
+ * @brief delivers mailbox messages in order of arrival.
+ * @details callbacks run outside m_inbound_lock so the receiver thread keeps
+ * superseding state messages while a slow callback runs.
+ */
+void de::comm::CModule::InternalInboundMailboxEntry ()
+{
+    std::unique_lock<std::mutex> lock(m_inbound_lock);
+
+    while (true)
+    {
+        m_inbound_cv.wait(lock, [this]() { return m_inbound_mailbox_stop || !m_inbound_mailbox.empty(); });
+        if (m_inbound_mailbox.empty()) break;
+
+        INBOUND_MESSAGE mailbox_message = std::move(m_inbound_mailbox.front());
+        m_inbound_mailbox.pop_front();
+        m_inbound_mailbox_bytes -= mailbox_message.message.length();
+
+        lock.unlock();
+#ifndef DE_DISABLE_TRY
+        try
+        {
+#endif
+            CInboundMessage inbound_message(mailbox_message.message.data(), mailbox_message.message.length(), getInboundArena(), m_inbound_parser);
+            if (mailbox_message.has_routing_prefix) inbound_message.setRoutingPrefix(mailbox_message.routing_prefix);
+            dispatchInboundMessage(inbound_message);
+#ifndef DE_DISABLE_TRY
+        }
+        catch(const std::exception& e)
+        {
+            std::cout << "ERROR:" << e.what() << std::endl ;
+        }
+#endif
+        lock.lock();
+    }
+}
+
+
+void de::comm::CModule::stopInboundMailbox ()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_inbound_lock);
+        // new messages are delivered directly from now on.
+        m_inbound_mailbox_enabled = false;
+        m_inbound_mailbox_stop = true;
+    }
+    m_inbound_cv.notify_one();
+
+    if (m_threadInboundMailbox.joinable())
+    {
+        m_threadInboundMailbox.join();
+    }
+}
+
+
+/**
+ * @brief hands a received message to the handler of its type or to the registered application callback.
+ * @details JSON DOM is built only for callbacks that need it.
+ * The DOM is not used after this call so it is moved
+ * into by-value and rvalue callbacks instead of being copied.
+ */
+void de::comm::CModule::dispatchInboundMessage (CInboundMessage& inbound_message)
+{
+    const char * message = inbound_message.getMessage();
+    const int len = static_cast<int>(inbound_message.getLength());
+
+    if (inbound_message.isBinary())
+    {
+        const int messageType = inbound_message.getEnvelope().getMessageType();
+        if ((messageType == TYPE_AndruavMessage_MAVLINK)
+            || (messageType == TYPE_AndruavMessage_SWARM_MAVLINK)
+            || (messageType == TYPE_AndruavMessage_INTERNAL_MAVLINK))
+        {
+            if (isMavlinkBatch(inbound_message))
+            {
+                deliverMavlinkBatch(inbound_message);
+                return ;
+            }
+            
+            if (m_OnReceiveMavlink != nullptr)
+            {
+                m_OnReceiveMavlink(inbound_message, inbound_message.getBinaryPayload());
+                return ;
+            }
+        }
+
+        if ((m_OnReceiveValueStream != nullptr) && deliverValueStream(inbound_message)) return ;
+    }
+
+    const MessageHandler * handler = m_message_handlers.findHandler(inbound_message.getEnvelope().getMessageType());
+    if (handler != nullptr)
+    {
+        (*handler)(inbound_message);
+        return ;
+    }
+
+    if (m_OnReceiveMessage != nullptr)
+    {
+        m_OnReceiveMessage(inbound_message);
+    }
+    else if (m_OnReceiveMove != nullptr)
+    {
+        m_OnReceiveMove(message, len, inbound_message.takeJson());
+    }
+    else if (m_OnReceiveRef != nullptr)
+    {
+        m_OnReceiveRef(message, len, inbound_message.getJson());
+    }
+    else if (m_OnReceive != nullptr)
+    {
+        m_OnReceive(message, len, inbound_message.takeJson());
+    }
+}
+
+
+/**
+ * @brief replaces a delta encoded message by the full message it stands for.
+ * @details the rebuilt message has no @link INTERMODULE_DELTA_HEADER @endlink so handlers,
+ * forwarding and the inbound mailbox only see complete messages.
+ * Called by the receive thread only.
+ * @return false if message must be dropped.
+ */
+bool de::comm::CModule::rebuildDeltaMessage (CInboundMessage& inbound_message)
+{
+    const CMessageEnvelope& envelope = inbound_message.getEnvelope();
+    const char * message = inbound_message.getMessage();
+
+    DELTA_HEADER delta_header;
+    if (!parseDeltaHeader(message + envelope.getDeltaHeaderBegin(), message + envelope.getDeltaHeaderEnd(), delta_header)) return false;
+
+    // a stream is the messages of one type from one sender to one target.
+    std::string stream_key;
+    stream_key.append(envelope.getSender());
+    stream_key.push_back('\n');
+    stream_key.append(envelope.getModuleKey());
+    stream_key.push_back('\n');
+    stream_key.append(envelope.getTargetId());
+    stream_key.push_back('\n');
+    stream_key += std::to_string(envelope.getMessageType());
+
+    Json_de json = inbound_message.takeJson();
+    if (!json.is_object() || !json.contains(ANDRUAV_PROTOCOL_MESSAGE_CMD)) return false;
+    if (!m_delta_decoder.decode(stream_key, delta_header, json[ANDRUAV_PROTOCOL_MESSAGE_CMD])) return false;
+    json.erase(INTERMODULE_DELTA_HEADER);
+
+    static thread_local std::string rebuilt_message;
+    rebuilt_message.clear();
+    appendJson(rebuilt_message, json);
+    // binary part if any and the 0 appended by CUDPClient.
+    rebuilt_message.append(message + envelope.getJsonEnd(), inbound_message.getLength() - envelope.getJsonEnd());
+
+    inbound_message.assign(rebuilt_message.data(), rebuilt_message.length(), std::move(json));
+    return true;
+}
+
+
+/**
+ * @brief true if MAVLink message carries @link MAVLINK_BATCH_FLAG @endlink.
+ * @details plain MAVLink messages have null "ms" so it is not parsed.
+ */
+bool de::comm::CModule::isMavlinkBatch (CInboundMessage& inbound_message) const
+{
+    const CMessageEnvelope& envelope = inbound_message.getEnvelope();
+    if (!envelope.hasCmd()) return false;
+    
+    const std::string_view cmd_text(inbound_message.getMessage() + envelope.getCmdBegin(), envelope.getCmdEnd() - envelope.getCmdBegin());
+    if (cmd_text == "null") return false;
+
+    const Json_de& cmd = inbound_message.getCmd();
+    return cmd.is_object() && cmd.contains(MAVLINK_BATCH_FLAG);
+}
+
+
+/**
+ * @brief splits a batch of MAVLink frames.
+ * @details frames are passed to the MAVLink callback if registered. Otherwise each frame
+ * is rebuilt as a plain MAVLink message so application callbacks see the same messages
+ * as if the sender did not batch.
+ */
+void de::comm::CModule::deliverMavlinkBatch (CInboundMessage& inbound_message)
+{
+    const CMessageEnvelope& envelope = inbound_message.getEnvelope();
+    const char * message = inbound_message.getMessage();
+    const CByteSpan batch = inbound_message.getBinaryPayload();
+
+    ++m_mavlink_batches_received;
+
+    std::string frame_message;
+    std::size_t pos = 0;
+    while (pos + 2 <= batch.size())
+    {
+        const std::size_t frame_length = static_cast<uint8_t>(batch.data()[pos]) | (static_cast<uint8_t>(batch.data()[pos + 1]) << 8);
+        pos += 2;
+
+        if (pos + frame_length > batch.size())
+        {
+            std::cout << "ERROR:" << "truncated MAVLink batch" << std::endl ;
+            return ;
+        }
+
+        const CByteSpan frame(batch.data() + pos, frame_length);
+        pos += frame_length;
+        ++m_mavlink_frames_received;
+
+        if (m_OnReceiveMavlink != nullptr)
+        {
+            m_OnReceiveMavlink(inbound_message, frame);
+            continue;
+        }
+
+        frame_message.assign(message, envelope.getCmdBegin());
+        frame_message += "null";
+        frame_message.append(message + envelope.getCmdEnd(), envelope.getJsonEnd() - envelope.getCmdEnd());
+        frame_message.push_back('\0');
+        frame_message.append(frame.data(), frame.size());
+        frame_message.push_back('\0');
+
+        CInboundMessage frame_inbound_message(frame_message.data(), frame_message.size(), getInboundArena(), m_inbound_parser);
+        dispatchInboundMessage(frame_inbound_message);
+    }
+}
+
+
+/**
+ * @brief passes records of a value stream batch to the value stream callback.
+ * @details descriptors carried by batches are remembered per sender and stream.
+ * @return false if message is not a value stream batch.
+ */
+bool de::comm::CModule::deliverValueStream (CInboundMessage& inbound_message)
+{
+    const CMessageEnvelope& envelope = inbound_message.getEnvelope();
+    if (!envelope.hasCmd()) return false;
+
+    // most binary messages are not streams. Look for the key before parsing "ms".
+    const std::string_view cmd_text(inbound_message.getMessage() + envelope.getCmdBegin(), envelope.getCmdEnd() - envelope.getCmdBegin());
+    if (cmd_text.find("\"" VALUE_STREAM_ID "\"") == std::string_view::npos) return false;
+
+    const Json_de& cmd = inbound_message.getCmd();
+    if (!cmd.is_object() || !cmd.contains(VALUE_STREAM_ID) || !cmd[VALUE_STREAM_ID].is_number_unsigned()) return false;
+    const uint64_t stream_id = cmd[VALUE_STREAM_ID].get<uint64_t>();
+
+    std::string stream_key;
+    stream_key.append(envelope.getSender());
+    stream_key.push_back('\n');
+    stream_key.append(envelope.getModuleKey());
+    stream_key.push_back('\n');
+    stream_key += std::to_string(envelope.getMessageType());
+    stream_key.push_back('\n');
+    stream_key += std::to_string(stream_id);
+
+    const CByteSpan batch = inbound_message.getBinaryPayload();
+
+    std::lock_guard<std::mutex> lock(m_value_stream_lock);
+
+    if (cmd.contains(VALUE_STREAM_DESCRIPTOR))
+    {
+        CValueStreamDescriptor descriptor;
+        if (descriptor.fromJson(cmd[VALUE_STREAM_DESCRIPTOR]) && (descriptor.getStreamId() == stream_id))
+        {
+            if ((m_value_stream_descriptors.size() >= VALUE_STREAM_MAX_DESCRIPTORS)
+                && (m_value_stream_descriptors.find(stream_key) == m_value_stream_descriptors.end()))
+            {
+                m_value_stream_descriptors.clear();
+            }
+            m_value_stream_descriptors[stream_key] = std::move(descriptor);
+        }
+    }
+
+    const auto it = m_value_stream_descriptors.find(stream_key);
+    if ((it == m_value_stream_descriptors.end()) || (batch.size() % it->second.getRecordSize() != 0))
+    {
+        ++m_value_batches_dropped;
+        return true;
+    }
+
+    const CValueStreamDescriptor& descriptor = it->second;
+    const std::size_t record_size = descriptor.getRecordSize();
+    for (std::size_t pos = 0; pos < batch.size(); pos += record_size)
+    {
+        ++m_value_records_received;
+        m_OnReceiveValueStream(inbound_message, CValueRecord(descriptor, batch.data() + pos));
+    }
+
+    return true;
+}
+
+
 void de::comm::CModule::appendExtraField(const std::string name, const Json_de& ms)
 {
+    std::lock_guard<std::mutex> lock(m_lock);
+
     // Add the provided ms object as an entry to m_stdinValues
     m_stdinValues[name] = ms;
 }
@@ -312,12 +1861,19 @@ void de::comm::CModule::appendExtraField(const std::string name, const Json_de&
  * @details generates JSON message that identifies module
  * 'a': module_id
  * 'b': module_class. fixed "fcb"
- * 'c': module_messages. can be updated from config file.
+ * 'c': module_messages. can be updated from config file and by subscribe/unsubscribe.
  * 'd': module_features. fixed per module. [T,R]
  * 'e': module_key. uniqueley identifies this instance and can be set in config file.
  * 's': hardware_serial. 
  * 't': hardware_type. 
  * 'z': resend request flag
+ * 'w': offered wire encoding. see setWireEncoding
+ * 'x': offered compression dictionary id. see setDictionaryCompression
+ * 'y': offered binary payload compression. see setPayloadCompression
+ * 'k': offered delta encoding. see setDeltaEncoding
+ * 'n': party ids offered for session aliases. see setSessionAliases
+ * 'r': offered routing prefix version. see setRoutingPrefix
+ * must be called while m_lock is held.
  * @param reSend if true then server should reply with server json_msg
  * @return 
  */
@@ -339,6 +1895,36 @@ void de::comm::CModule::createJSONID (bool reSend)
         ms[JSON_INTERMODULE_VERSION]                = m_module_version;
         ms[JSON_INTERMODULE_RESEND]                 = reSend;
         ms[JSON_INTERMODULE_TIMESTAMP_INSTANCE]     = m_instance_time_stamp;
+        if (m_offered_encoding != DATABUS_ENCODING_JSON)
+        {
+            ms[JSON_INTERMODULE_WIRE_ENCODING]      = getEncodingName(m_offered_encoding);
+        }
+        const std::shared_ptr<const CDictionaryCodec> dictionary_codec = std::atomic_load(&m_dictionary_codec);
+        if (dictionary_codec != nullptr)
+        {
+            ms[JSON_INTERMODULE_DICTIONARY_ID]      = dictionary_codec->getDictionaryId();
+        }
+        if (m_payload_compression_offered)
+        {
+            ms[JSON_INTERMODULE_PAYLOAD_COMPRESSION] = DATABUS_PAYLOAD_COMPRESSION_NAME_LZ4;
+        }
+        if (!m_delta_config.empty())
+        {
+            ms[JSON_INTERMODULE_DELTA_ENCODING]     = true;
+        }
+        if (m_routing_prefix_offered)
+        {
+            ms[JSON_INTERMODULE_ROUTING_PREFIX]     = ROUTING_PREFIX_VERSION;
+        }
+        if (m_binary_telemetry_offered)
+        {
+            ms[JSON_INTERMODULE_BINARY_TELEMETRY]   = true;
+        }
+        if (m_session_aliases_offered)
+        {
+            // module key alias is asked for even if no party is frequent yet.
+            ms[JSON_INTERMODULE_SESSION_ALIASES]    = m_party_table.getFrequentParties();
+        }
 
         // Add fields from m_stdinValues to ms
         for (const std::pair<std::string, Json_de>&  entry : m_stdinValues) {
@@ -353,6 +1939,7 @@ void de::comm::CModule::createJSONID (bool reSend)
             //std::cout << json_msg.dump(4) << std::endl;              
         #endif
 
+        m_id_resend = reSend;
         cUDPClient.setJsonId (json_msg.dump());
 
         return ;
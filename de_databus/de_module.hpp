@@ -3,12 +3,34 @@
 
 
 #include <ctime>
+#include <functional>
 #include <iostream>
-
-#include "../helpers/json_nlohmann.hpp"
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+
+#include "../helpers/json_de.hpp"
 #include "udpClient.hpp"
 #include "messages.hpp"
-using Json_de = nlohmann::json;
+#include "de_inbound_message.hpp"
+#include "de_telemetry_messages.hpp"
+#include "de_message_registry.hpp"
+#include "de_buffer_pool.hpp"
+#include "de_json_writer.hpp"
+#include "de_wire_encoding.hpp"
+#include "de_delta_codec.hpp"
+#include "de_party_table.hpp"
+#include "de_routing_prefix.hpp"
+#include "de_message_prefilter.hpp"
+#include "de_value_stream.hpp"
+#include "de_dispatch_table.hpp"
 
 typedef enum {
     HARDWARE_TYPE_UNDEFINED     = 0,
@@ -36,6 +58,61 @@ typedef enum {
 #define MODULE_CLASS_TRACKING                   "trk" 
 
 
+// maximum number of MAVLink streams (pre-rendered headers) kept by CModule.
+// A new stream then evicts the least recently used plain stream, or the least recently used batching one.
+#define MAX_MAVLINK_HEADER_CACHE                16
+
+// set in ANDRUAV_PROTOCOL_MESSAGE_CMD of a MAVLink message that carries a batch of frames.
+// binary part is then a sequence of [uint16 little endian frame length][frame].
+#define MAVLINK_BATCH_FLAG                      "bt"
+#define MAX_MAVLINK_BATCH_FRAME_SIZE            0xffff
+
+// default limits of the outbound queue. Oldest messages are dropped beyond them. see CModule::setOutboundQueue
+#define OUTBOUND_QUEUE_MAX_MESSAGES             1024
+#define OUTBOUND_QUEUE_MAX_BYTES                (4 * 1024 * 1024)
+// buffers of sent messages kept for the buffer pool of sending threads.
+#define OUTBOUND_QUEUE_FREE_BUFFERS             (BUFFER_POOL_SIZE_CLASSES * BUFFER_POOL_MAX_FREE_BUFFERS)
+
+// default limits of the inbound mailbox. Oldest state messages are dropped beyond them. see CModule::setInboundMailbox
+#define INBOUND_MAILBOX_MAX_MESSAGES            1024
+#define INBOUND_MAILBOX_MAX_BYTES               (4 * 1024 * 1024)
+
+
+typedef struct
+{
+    // sender side
+    uint64_t frames_batched;
+    uint64_t batches_sent;
+    uint64_t window_flushes;
+    uint64_t budget_flushes;
+    // streams dropped from the header cache. see MAX_MAVLINK_HEADER_CACHE
+    uint64_t streams_evicted;
+    // receiver side
+    uint64_t batches_received;
+    uint64_t frames_received;
+} MAVLINK_BATCH_COUNTERS;
+
+
+typedef struct
+{
+    // replaced by a newer message of the same type, routing type and target while queued.
+    uint64_t coalesced;
+    // dropped because its deadline passed while queued.
+    uint64_t expired;
+    // dropped as the oldest message of a full queue.
+    uint64_t dropped;
+} OUTBOUND_MESSAGE_COUNTERS;
+
+
+typedef struct
+{
+    // replaced by a newer message of the same type and sender while waiting.
+    uint64_t superseded;
+    // dropped as the oldest state message of a full mailbox.
+    uint64_t dropped;
+} INBOUND_MESSAGE_COUNTERS;
+
+
 namespace de
 {
 
@@ -43,6 +120,10 @@ namespace comm
 {
     class CModule : public CCallBack_UDPClient
     {
+        public:
+
+            typedef std::function<void(const CInboundMessage& message)> MessageHandler;
+
         public:
 
             static CModule& getInstance()
@@ -64,6 +145,15 @@ namespace comm
                 m_hardware_serial_type = HARDWARE_TYPE_UNDEFINED;
 
             }
+
+        public:
+
+            ~CModule()
+            {
+                stopMavlinkBatching();
+                stopOutboundQueue();
+                stopInboundMailbox();
+            }
         
         public:
 
@@ -83,45 +173,431 @@ namespace comm
 
         public:
 
+            void sendBMSG (const std::string_view targetPartyID, const char * bmsg, const int bmsg_length, const int& andruav_message_id, const bool& internal_message, const Json_de& message_cmd);
+            void sendJMSG (const std::string_view targetPartyID, const Json_de& jmsg, const int andruav_message_id, const bool internal_message);
+            void sendSYSMSG (const Json_de& jmsg, const int& andruav_message_id);
+
+#ifdef DE_MODULE_BUILD_REMOVED_API
+            /**
+             * @brief former by-value signatures, kept as wrappers for modules linked against older builds.
+             * @details declared only in de_module_removed_api.cpp. Next to the overloads above they would make
+             * calls with string literals ambiguous and calls with std::string pick the copying form.
+             */
             void sendBMSG (const std::string& targetPartyID, const char * bmsg, const int bmsg_length, const int& andruav_message_id, const bool& internal_message, const Json_de& message_cmd);
             void sendJMSG (const std::string targetPartyID, const Json_de jmsg, const int andruav_message_id, const bool internal_message);
-            void sendSYSMSG (const Json_de& jmsg, const int& andruav_message_id);
+#endif
+
+            /**
+             * @brief sends typed telemetry such as CTelemetryGPS.
+             * @details uses packed binary codec when the target was negotiated to decode it,
+             * otherwise sends the legacy JSON message. see setBinaryTelemetry
+             */
+            template <typename T>
+            void sendTelemetry (const std::string_view targetPartyID, const T& telemetry, const bool internal_message)
+            {
+                if (isBinaryTelemetryAccepted(targetPartyID))
+                {
+                    char buffer[T::BINARY_SIZE];
+                    telemetry.encode(buffer);
+                    sendBMSG(targetPartyID, buffer, T::BINARY_SIZE, T::MESSAGE_TYPE, internal_message, Json_de());
+                }
+                else
+                {
+                    sendJMSG(targetPartyID, telemetry.toJson(), T::MESSAGE_TYPE, internal_message);
+                }
+            }
+
+            /**
+             * @brief offers binary telemetry in TYPE_AndruavModule_ID.
+             * @details the communicator answers in its TYPE_AndruavModule_ID reply with true when every party
+             * it reaches decodes telemetry using decodeTelemetry(), or with the ids of the parties that do.
+             * sendTelemetry() then sends packed binary messages to those targets and legacy JSON to the others.
+             * Group messages are binary only when the answer is true.
+             */
+            void setBinaryTelemetry (const bool enabled);
+
+            /**
+             * @brief limits decimal places of a floating point field in "ms" of a message type.
+             * @details e.g. 7 for latitude and longitude, 2 for voltages. Shrinks text messages
+             * and replaces rounding values with roundToPrecision() before sending.
+             * @param decimal_places negative removes the limit.
+             */
+            void setFieldPrecision (const int andruav_message_id, const std::string& field, const int decimal_places);
+
+            /**
+             * @brief offers a binary wire encoding in TYPE_AndruavModule_ID.
+             * @details messages are sent encoded only after the communicator accepts the offer
+             * in its TYPE_AndruavModule_ID reply. Otherwise JSON is used.
+             * Received frames are decoded whatever was negotiated.
+             */
+            void setWireEncoding (const ENUM_DATABUS_ENCODING encoding);
+
+            /**
+             * @brief encoding used for sending, as negotiated with the communicator.
+             */
+            ENUM_DATABUS_ENCODING getWireEncoding ();
+
+            /**
+             * @brief offers zstd dictionary compression in TYPE_AndruavModule_ID.
+             * @details needs DE_ENABLE_ZSTD. Messages of at least min_size bytes are compressed once
+             * the communicator accepts the dictionary id in its TYPE_AndruavModule_ID reply.
+             * Received compressed frames are decompressed with the same dictionary.
+             * @param dictionary trained by CDictionaryCodec::train(). Empty withdraws the offer.
+             * @return false if dictionary can not be loaded.
+             */
+            bool setDictionaryCompression (const std::string& dictionary, const std::size_t min_size);
+
+            /**
+             * @brief offers LZ4 compression of sendBMSG binary parts in TYPE_AndruavModule_ID.
+             * @details needs DE_ENABLE_LZ4. Binary parts of at least min_size bytes are compressed before
+             * they are split into chunks once the communicator accepts the offer in its TYPE_AndruavModule_ID reply.
+             * Parts that do not compress, such as JPEG images, are sent as they are.
+             * Received compressed parts are decompressed after reassembly whatever was negotiated.
+             * @return false if LZ4 support is not built in.
+             */
+            bool setPayloadCompression (const bool enabled, const std::size_t min_size);
+
+            /**
+             * @brief sends sendJMSG messages of a type as changes to the previous message of the same type and target.
+             * @details offered in TYPE_AndruavModule_ID and used once the communicator accepts it.
+             * Periodic keyframes carry the full message and other messages carry a JSON merge patch
+             * of the fields that changed. Receivers rebuild the full message before it reaches any handler
+             * and drop deltas whose base message was lost until the next keyframe.
+             * Delta encoded messages are never coalesced by the outbound queue.
+             * @param keyframe_interval a keyframe is sent every keyframe_interval messages. Zero disables delta encoding of this type.
+             * @param keyframe_period_ms a keyframe is also sent when the last one is older than this. Zero means no time limit.
+             * @param reference loss recovery. see @link ENUM_DELTA_REFERENCE @endlink
+             */
+            void setDeltaEncoding (const int andruav_message_id, const uint32_t keyframe_interval, const uint32_t keyframe_period_ms, const ENUM_DELTA_REFERENCE reference);
+
+            DELTA_ENCODING_COUNTERS getDeltaEncodingCounters ();
+
+            /**
+             * @brief offers session aliases in TYPE_AndruavModule_ID.
+             * @details the communicator assigns short numbers to the module key and to party ids that
+             * at least min_uses messages were sent to. Envelopes then carry @link INTERMODULE_MODULE_KEY_ALIAS @endlink
+             * and @link INTERMODULE_TARGET_ID_ALIAS @endlink instead of the strings, and the communicator restores
+             * them before forwarding. A TYPE_AndruavModule_ID reply without aliases drops them.
+             */
+            void setSessionAliases (const bool enabled, const uint32_t min_uses = SESSION_ALIAS_MIN_USES);
+
+            /**
+             * @brief offers a binary routing prefix in TYPE_AndruavModule_ID. see @link ROUTING_PREFIX_MARKER @endlink
+             * @details messages are prefixed once the communicator accepts the offered version
+             * in its TYPE_AndruavModule_ID reply, so it can route them without parsing JSON.
+             * Received prefixed messages are accepted whatever was negotiated.
+             */
+            void setRoutingPrefix (const bool enabled);
+
+            /**
+             * @brief drops received messages whose type is not in the message_filter of defineModule
+             * before they are parsed. see CMessagePrefilter
+             * @details control messages 9000..9999 and messages whose type cannot be found cheaply
+             * (encoded frames) always pass.
+             */
+            inline void setMessagePrefilter (const bool enabled) { m_message_prefilter.setEnabled(enabled); }
+
+            /**
+             * @return passed and filtered messages by message type. Counted while the prefilter is enabled.
+             */
+            inline std::map<int, MESSAGE_PREFILTER_COUNTERS> getMessagePrefilterCounters () { return m_message_prefilter.getCounters(); }
+
+            /**
+             * @brief MAVLink passthrough fast path.
+             * @details sends a raw MAVLink frame as binary message of type
+             * TYPE_AndruavMessage_MAVLINK, TYPE_AndruavMessage_SWARM_MAVLINK or TYPE_AndruavMessage_INTERNAL_MAVLINK.
+             * JSON header is rendered once per target, routing type and message type and reused afterwards,
+             * and the frame is appended to a reused buffer. Output is identical to
+             * sendBMSG(targetPartyID, frame, frame_length, andruav_message_id, internal_message, Json_de()).
+             */
+            void sendMAVLINK (const std::string_view targetPartyID, const char * frame, const int frame_length, const int andruav_message_id, const bool internal_message);
+
+            /**
+             * @brief enables batching of sendMAVLINK frames of one stream.
+             * @details a stream is a target, routing type and message type combination.
+             * Frames are accumulated and sent as one message when the first queued frame is
+             * window_ms old or when queued frames reach byte_budget bytes, whichever comes first.
+             * Larger window means fewer datagrams but more latency.
+             * Receivers must run a version of CModule that understands @link MAVLINK_BATCH_FLAG @endlink.
+             * A stream evicted when more than MAX_MAVLINK_HEADER_CACHE streams are used is flushed
+             * and sends unbatched frames until batching is set again.
+             * @param window_ms zero disables batching of this stream and flushes queued frames.
+             * @param byte_budget maximum size of frames and their length prefixes in one batch.
+             */
+            void setMavlinkBatching (const std::string_view targetPartyID, const int andruav_message_id, const bool internal_message, const uint32_t window_ms, const uint32_t byte_budget);
+
+            MAVLINK_BATCH_COUNTERS getMavlinkBatchCounters ();
+
+            /**
+             * @brief declares a stream of fixed layout records such as IMU samples or tracker boxes.
+             * @details values pushed by pushValues() are packed as described by descriptor and sent in batches
+             * as binary messages of type andruav_message_id. Keys are not repeated: the descriptor travels
+             * in "ms" of the first batch and then every @link VALUE_STREAM_DESCRIPTOR_PERIOD_MS @endlink
+             * so receivers that join later can decode the stream.
+             * A batch is sent when it holds max_records records or when its first record is window_ms old.
+             * Declaring a stream id again sends its queued records then replaces it.
+             * Receivers must run a version of CModule that understands @link VALUE_STREAM_ID @endlink.
+             * @param window_ms zero sends every record as soon as it is pushed.
+             * @param max_records zero removes the stream.
+             */
+            void defineValueStream (const std::string_view targetPartyID, const int andruav_message_id, const bool internal_message,
+                                    const CValueStreamDescriptor& descriptor, const uint32_t window_ms, const uint16_t max_records);
+
+            /**
+             * @param values one value per descriptor field in declaration order.
+             * @return false if stream is not declared or count does not match its fields.
+             */
+            bool pushValues (const uint16_t stream_id, const double * values, const std::size_t count);
+
+            VALUE_STREAM_COUNTERS getValueStreamCounters ();
+
+            /**
+             * @brief sends messages from a queue in a separate thread.
+             * @details when the link is slower than the send rate, a message of a coalescable
+             * type (see @link MESSAGE_TYPE_REGISTRY @endlink) replaces a queued message of
+             * the same type, routing type and target instead of queueing behind it.
+             * Other messages are appended, so the queue is capped: when it holds max_messages
+             * or max_bytes, the oldest messages are dropped to make room.
+             * Disabling sends remaining queued messages before any new message is sent directly.
+             */
+            void setOutboundQueue (const bool enabled, const std::size_t max_messages = OUTBOUND_QUEUE_MAX_MESSAGES,
+                                   const std::size_t max_bytes = OUTBOUND_QUEUE_MAX_BYTES);
+
+            /**
+             * @brief drops queued messages of a type that waited more than deadline_ms.
+             * @param deadline_ms zero means no deadline.
+             */
+            void setOutboundDeadline (const int andruav_message_id, const uint32_t deadline_ms);
+
+            /**
+             * @brief per message type coalesce, expiry and overflow drop counts of the outbound queue.
+             */
+            std::map<int, OUTBOUND_MESSAGE_COUNTERS> getOutboundQueueCounters ();
+
+            /**
+             * @brief delivers received messages to application callbacks from a separate thread.
+             * @details if callbacks are slower than inbound rate, a message of a state
+             * (coalescable) type removes a waiting message of the same type and sender so
+             * only the newest instance is delivered, in its own order of arrival.
+             * Other messages are appended, so the mailbox is capped: when it holds max_messages
+             * or max_bytes, the oldest state messages are dropped to make room. Commands are never
+             * dropped: when only commands wait, the mailbox grows beyond its limits.
+             * Disabling delivers remaining messages.
+             */
+            void setInboundMailbox (const bool enabled, const std::size_t max_messages = INBOUND_MAILBOX_MAX_MESSAGES,
+                                    const std::size_t max_bytes = INBOUND_MAILBOX_MAX_BYTES);
+
+            /**
+             * @brief per message type supersede and overflow drop counts of the inbound mailbox.
+             */
+            std::map<int, INBOUND_MESSAGE_COUNTERS> getInboundMailboxCounters ();
+
+            /**
+             * @brief parses received messages into a per thread arena that is released in one step after dispatch.
+             * @details effective only when built with DE_JSON_ARENA.
+             * Only DOMs seen as const Json_de& (CInboundMessage::getJson and getCmd, and the const
+             * reference receive callback) are in the arena and valid only during the callback.
+             * Callbacks that take the DOM by value or rvalue, and parsers, get heap DOMs.
+             * Copies made by the application are allocated normally.
+             */
+            inline void setInboundArena (const bool enabled)
+            {
+                m_inbound_arena = enabled;
+            }
+
+            /**
+             * @brief selects the parser that builds DOMs of received messages.
+             * @details JSON_PARSER_STRUCTURAL pays off for large "ms" sections.
+             * Results are identical to JSON_PARSER_NLOHMANN. see @link parseJson @endlink
+             */
+            inline void setInboundParser (const ENUM_JSON_PARSER parser)
+            {
+                m_inbound_parser = parser;
+            }
+
             void sendMREMSG (const int& command_type);
+
+            /**
+             * @brief adds message types to the message_filter of defineModule at runtime.
+             * @details the prefilter is updated and the added types are sent to the communicator
+             * as TYPE_AndruavModule_Subscription. The ID message carries the whole list from now on,
+             * so a lost update is repaired by the next ID message.
+             */
+            void subscribe (const std::vector<int>& message_types);
+
+            /**
+             * @brief removes message types from the message_filter of defineModule. see subscribe
+             */
+            void unsubscribe (const std::vector<int>& message_types);
             void forwardMSG (const char * message, const std::size_t datalength);
 
         public:
 
+            /**
+             * @brief register application receive callback.
+             * @details only one callback is active at a time. Registering any of
+             * the overloads replaces the previous one.
+             * The by-value form is kept for existing modules. The message DOM is moved
+             * into it so no copy is made.
+             */
             void setMessageOnReceive (void (*onReceive)(const char *, int len, Json_de jMsg))
                 {
+                    clearMessageOnReceive();
                     m_OnReceive = onReceive;
                 }
+
+            void setMessageOnReceive (void (*onReceive)(const char *, int len, const Json_de& jMsg))
+                {
+                    clearMessageOnReceive();
+                    m_OnReceiveRef = onReceive;
+                }
+
+            void setMessageOnReceive (void (*onReceive)(const char *, int len, Json_de&& jMsg))
+                {
+                    clearMessageOnReceive();
+                    m_OnReceiveMove = onReceive;
+                }
+
+            /**
+             * @brief lazy form of the receive callback.
+             * @details envelope fields are available without parsing.
+             * JSON DOM is built only if the callback calls @link CInboundMessage::getJson @endlink
+             * or @link CInboundMessage::getCmd @endlink.
+             */
+            void setMessageOnReceive (void (*onReceive)(const CInboundMessage& message))
+                {
+                    clearMessageOnReceive();
+                    m_OnReceiveMessage = onReceive;
+                }
         
+            /**
+             * @brief receive handler of one message type.
+             * @details called instead of the application callback for messages of this type, so
+             * independent parts of a module each receive their own types without a switch on mt.
+             * Handlers are found in O(1). see CDispatchTable
+             * setMavlinkOnReceive and setValueStreamOnReceive take precedence for their messages.
+             * Pass nullptr to remove a handler.
+             * @return false if called after init(): the receive thread reads the handlers without a lock,
+             * so they are registered at startup and the handler table is left unchanged.
+             */
+            bool setMessageHandler (const int message_type, MessageHandler handler);
+
+            /**
+             * @brief binds a member function as receive handler of one message type. see setMessageHandler
+             */
+            template <typename T>
+            bool setMessageHandler (const int message_type, T * object, void (T::*method)(const CInboundMessage& message))
+                {
+                    return setMessageHandler(message_type, [object, method](const CInboundMessage& message) { (object->*method)(message); });
+                }
+
+            /**
+             * @return false if called after init(). see setMessageHandler
+             */
+            bool removeMessageHandler (const int message_type);
+
+            /**
+             * @brief receive callback for MAVLink binary messages.
+             * @details called instead of the application callback for
+             * TYPE_AndruavMessage_MAVLINK, TYPE_AndruavMessage_SWARM_MAVLINK and TYPE_AndruavMessage_INTERNAL_MAVLINK.
+             * frame is the binary part of the message. No JSON DOM is built.
+             * Batched messages are split and the callback is called once per frame.
+             * pass nullptr to deliver MAVLink messages to the application callback again.
+             */
+            void setMavlinkOnReceive (void (*onReceive)(const CInboundMessage& message, const CByteSpan& frame))
+                {
+                    m_OnReceiveMavlink = onReceive;
+                }
+
+            /**
+             * @brief receive callback for value streams. see @link defineValueStream @endlink
+             * @details called once per record instead of the application callback.
+             * Records of a stream whose descriptor has not been received yet are dropped.
+             * pass nullptr to deliver value stream batches to the application callback as binary messages.
+             */
+            void setValueStreamOnReceive (void (*onReceive)(const CInboundMessage& message, const CValueRecord& record))
+                {
+                    m_OnReceiveValueStream = onReceive;
+                }
+
             void sendMSG (const char * msg, const int length)
                 {
                     if (!cUDPClient.isStarted()) return ;
                     cUDPClient.sendMSG (msg, length);
                 }
 
+            void sendMSG (const char * prefix, const int prefix_length, const char * msg, const int length)
+                {
+                    if (!cUDPClient.isStarted()) return ;
+                    cUDPClient.sendMSG (prefix, prefix_length, msg, length);
+                }
+
 
             void onReceive (const char *, int len) override;
 
-        public:
+        private:
+
+            inline void clearMessageOnReceive ()
+                {
+                    m_OnReceive = nullptr;
+                    m_OnReceiveRef = nullptr;
+                    m_OnReceiveMove = nullptr;
+                    m_OnReceiveMessage = nullptr;
+                }
+
+            inline CJsonArena * getInboundArena () const
+            {
+                return m_inbound_arena ? &CJsonArena::getThreadInstance() : nullptr;
+            }
+
+            void deliverMessage (CInboundMessage& inbound_message);
+            void dispatchInboundMessage (CInboundMessage& inbound_message);
+            void stopInboundMailbox ();
+            void InternalInboundMailboxEntry ();
+
+            std::size_t getMavlinkStream (const std::string_view targetPartyID, const int andruav_message_id, const bool internal_message);
+            void flushMavlinkBatch (std::size_t stream_index);
+            void resetMavlinkStreams ();
+            void stopMavlinkBatching ();
+            void InternalMavlinkBatchEntry ();
+
+            void queueMSG (std::string&& msg, const int andruav_message_id, const PARTY_HANDLE target_party, const char * msg_routing_type, const bool can_coalesce = true);
+            void queueMSG (const char * msg, const int length, const int andruav_message_id, const PARTY_HANDLE target_party, const char * msg_routing_type);
+            void enqueueMSG (std::string&& msg, const int andruav_message_id, const PARTY_HANDLE target_party, const ENUM_ROUTING_TYPE routing_type,
+                             const char * routing_prefix, const int routing_prefix_length, const bool can_coalesce = true);
+            int getRoutingPrefix (const int andruav_message_id, const PARTY_HANDLE target_party, const char * msg_routing_type, char * routing_prefix) const;
+            void waitOutboundQueueDrained (std::unique_lock<std::mutex>& lock);
+            void recycleOutboundBuffer (std::string&& buffer);
+            void stopOutboundQueue ();
+            void InternalOutboundQueueEntry ();
+
+            bool isMavlinkBatch (CInboundMessage& inbound_message) const;
+            void deliverMavlinkBatch (CInboundMessage& inbound_message);
+            bool deliverValueStream (CInboundMessage& inbound_message);
+
+            PARTY_HANDLE addParty (const std::string_view party_id);
+            PARTY_HANDLE internParty (const std::string_view targetPartyID);
+            void countPartyUse (const PARTY_HANDLE target_party);
+            bool isBinaryTelemetryAccepted (const std::string_view targetPartyID);
 
             /**
-             * @brief creates JSON message that identifies Module
-             * @details generates JSON message that identifies module
-             * 'a': module_id
-             * 'b': module_class. fixed "fcb"
-             * 'c': module_messages. can be updated from config file.
-             * 'd': module_features. fixed per module. [T,R]
-             * 'e': module_key. uniqueley identifies this instance and can be set in config file.
-             * 's': hardware_serial. 
-             * 't': hardware_type. 
-             * 'z': resend request flag
+             * @brief creates JSON message that identifies Module. see de_module.cpp for its fields.
+             * @details must be called while m_lock is held.
              * @param reSend if true then server should reply with server json_msg
              */
             void createJSONID (bool reSend) ;
 
+            void serializeMessage (std::string& out, const PARTY_HANDLE target_party, const char * msg_routing_type, const int andruav_message_id, const Json_de& message_cmd, const DELTA_HEADER * delta_header = nullptr) const;
+            void serializeJsonMessage (std::string& out, const PARTY_HANDLE target_party, const char * msg_routing_type, const int andruav_message_id, const Json_de& message_cmd, const DELTA_HEADER * delta_header) const;
+
+            bool rebuildDeltaMessage (CInboundMessage& inbound_message);
+
+            void appendBinaryPart (std::string& msg, const char * bmsg, const std::size_t bmsg_length) const;
+
+        public:
+
+            void sendSubscriptionDelta (const Json_de& subscribed, const Json_de& unsubscribed);
+
 
             
 
@@ -166,7 +642,9 @@ namespace comm
 
             void setModuleKey(const char* module_key) 
             {
+                std::lock_guard<std::mutex> lock(m_lock);
                 m_module_key = module_key;
+                resetMavlinkStreams();
             }
 
 
@@ -190,9 +668,13 @@ namespace comm
 
         public:
 
+            /**
+             * @brief adds a field to the ms section of the ID message. Thread safe.
+             */
             void appendExtraField(const std::string name, const Json_de& ms);
         
         protected:
+            // guarded by m_lock. see createJSONID
             std::map <std::string,Json_de> m_stdinValues;
             
 
@@ -254,8 +736,195 @@ namespace comm
             std::string  m_group_id;
             
             Json_de m_message_filter;
+            // resend flag of the current ID message. see createJSONID
+            bool m_id_resend = true;
+
+            bool m_binary_telemetry_offered = false;
+            // binary telemetry answer of the communicator: all parties, or these party ids. guarded by m_lock.
+            bool m_binary_telemetry_accepted_all = false;
+            std::set<std::string, std::less<>> m_binary_telemetry_parties;
+
+            /**
+             * @brief decimal places per field, by message type. see setFieldPrecision
+             */
+            std::map<int, JSON_FIELD_PRECISION> m_field_precision;
+
+            ENUM_DATABUS_ENCODING m_offered_encoding = DATABUS_ENCODING_JSON;
+            ENUM_DATABUS_ENCODING m_wire_encoding = DATABUS_ENCODING_JSON;
+
+            /**
+             * @brief offered dictionary. Read by the receive thread using std::atomic_load.
+             */
+            std::shared_ptr<const CDictionaryCodec> m_dictionary_codec;
+            bool m_dictionary_accepted = false;
+            std::size_t m_dictionary_min_size = 0;
+
+            bool m_payload_compression_offered = false;
+            bool m_payload_compression_accepted = false;
+            std::size_t m_payload_compression_min_size = 0;
+
+            /**
+             * @brief delta encoded message types. see setDeltaEncoding
+             */
+            std::map<int, DELTA_ENCODING_CONFIG> m_delta_config;
+            bool m_delta_accepted = false;
+            CDeltaEncoder m_delta_encoder;
+            CDeltaDecoder m_delta_decoder;
+
+            /**
+             * @brief party ids messages are sent to. guarded by m_lock.
+             */
+            CPartyTable m_party_table;
+            bool m_session_aliases_offered = false;
+            uint32_t m_session_alias_min_uses = SESSION_ALIAS_MIN_USES;
+            uint16_t m_module_key_alias = 0;
+            // an ID message asking for aliases is being sent. see internParty
+            bool m_session_aliases_requested = false;
+
+            bool m_routing_prefix_offered = false;
+            bool m_routing_prefix_accepted = false;
+
+            /**
+             * @brief thread safe. Used by the receive thread without m_lock.
+             */
+            CMessagePrefilter m_message_prefilter;
+
+            bool m_inbound_arena = false;
+
+            ENUM_JSON_PARSER m_inbound_parser = JSON_PARSER_NLOHMANN;
+
+            /**
+             * @brief MAVLink stream with its pre-rendered JSON headers including the 0 separator.
+             * @details headers are rendered on first use and cleared when module key changes.
+             */
+            typedef struct
+            {
+                int andruav_message_id;
+                const char * routing_type;
+                PARTY_HANDLE target_party;
+                std::string header;
+                std::string batch_header;
+                uint32_t batch_window_ms;
+                uint32_t batch_byte_budget;
+                // batch_header followed by queued frames. empty if nothing is queued.
+                std::string batch;
+                std::chrono::steady_clock::time_point batch_deadline;
+                // value of m_mavlink_stream_uses when last used.
+                uint64_t last_use;
+            } MAVLINK_STREAM;
+
+            std::vector<MAVLINK_STREAM> m_mavlink_streams;
+            uint64_t m_mavlink_stream_uses = 0;
+
+            /**
+             * @brief reused by sendMAVLINK so that sending a frame does not allocate.
+             */
+            std::string m_mavlink_buffer;
+
+            MAVLINK_BATCH_COUNTERS m_mavlink_batch_counters = {};
+            std::atomic<uint64_t> m_mavlink_batches_received {0};
+            std::atomic<uint64_t> m_mavlink_frames_received {0};
+
+            typedef struct
+            {
+                CValueStreamDescriptor descriptor;
+                int andruav_message_id;
+                const char * routing_type;
+                PARTY_HANDLE target_party;
+                uint32_t window_ms;
+                uint16_t max_records;
+                // packed records waiting to be sent.
+                std::string batch;
+                uint16_t batch_records;
+                std::chrono::steady_clock::time_point batch_deadline;
+                bool descriptor_sent;
+                std::chrono::steady_clock::time_point descriptor_time;
+            } VALUE_STREAM;
+
+            void flushValueStream (VALUE_STREAM& stream);
+
+            std::map<uint16_t, VALUE_STREAM> m_value_streams;
+            VALUE_STREAM_COUNTERS m_value_stream_counters = {};
+
+            /**
+             * @brief descriptors of received streams by sender, module key, message type and stream id.
+             * guarded by m_value_stream_lock.
+             */
+            std::map<std::string, CValueStreamDescriptor, std::less<>> m_value_stream_descriptors;
+            std::atomic<uint64_t> m_value_records_received {0};
+            std::atomic<uint64_t> m_value_batches_dropped {0};
+            std::mutex m_value_stream_lock;
+
+            /**
+             * @brief flushes MAVLink and value stream batches whose window expired.
+             */
+            std::thread m_threadMavlinkBatch;
+            std::condition_variable m_mavlink_batch_cv;
+            bool m_mavlink_batch_stop = false;
+
+            typedef struct
+            {
+                int andruav_message_id;
+                bool has_deadline;
+                std::chrono::steady_clock::time_point deadline;
+                PARTY_HANDLE target_party;
+                ENUM_ROUTING_TYPE routing_type;
+                char routing_prefix[ROUTING_PREFIX_SIZE];
+                int routing_prefix_length;
+                std::string message;
+            } OUTBOUND_MESSAGE;
+
+            /**
+             * @brief outbound queue state. guarded by m_outbound_lock.
+             * @details coalescing scans the queue linearly. Coalescing keeps state messages
+             * to one per type, routing type and target. Everything else is appended, so
+             * m_outbound_max_messages and m_outbound_max_bytes bound the queue.
+             */
+            std::deque<OUTBOUND_MESSAGE> m_outbound_queue;
+            std::size_t m_outbound_queue_bytes = 0;
+            std::size_t m_outbound_max_messages = OUTBOUND_QUEUE_MAX_MESSAGES;
+            std::size_t m_outbound_max_bytes = OUTBOUND_QUEUE_MAX_BYTES;
+            // buffers of sent messages waiting to return to a sender's pool. see recycleOutboundBuffer
+            std::vector<std::string> m_outbound_free_buffers;
+            std::map<int, uint32_t> m_outbound_deadlines;
+            std::map<int, OUTBOUND_MESSAGE_COUNTERS> m_outbound_counters;
+            bool m_outbound_queue_enabled = false;
+            bool m_outbound_queue_stop = false;
+            std::thread m_threadOutboundQueue;
+            std::condition_variable m_outbound_cv;
+            std::condition_variable m_outbound_drained_cv;
+            std::mutex m_outbound_lock;
+
+            typedef struct
+            {
+                int andruav_message_id;
+                std::string sender;
+                std::string message;
+                bool has_routing_prefix;
+                ROUTING_PREFIX routing_prefix;
+            } INBOUND_MESSAGE;
+
+            /**
+             * @brief inbound mailbox state. guarded by m_inbound_lock.
+             */
+            std::deque<INBOUND_MESSAGE> m_inbound_mailbox;
+            std::size_t m_inbound_mailbox_bytes = 0;
+            std::size_t m_inbound_max_messages = INBOUND_MAILBOX_MAX_MESSAGES;
+            std::size_t m_inbound_max_bytes = INBOUND_MAILBOX_MAX_BYTES;
+            std::map<int, INBOUND_MESSAGE_COUNTERS> m_inbound_counters;
+            bool m_inbound_mailbox_enabled = false;
+            bool m_inbound_mailbox_stop = false;
+            std::thread m_threadInboundMailbox;
+            std::condition_variable m_inbound_cv;
+            std::mutex m_inbound_lock;
 
             void (*m_OnReceive)(const char *, int len, Json_de jMsg) = nullptr;
+            void (*m_OnReceiveRef)(const char *, int len, const Json_de& jMsg) = nullptr;
+            void (*m_OnReceiveMove)(const char *, int len, Json_de&& jMsg) = nullptr;
+            void (*m_OnReceiveMessage)(const CInboundMessage& message) = nullptr;
+            void (*m_OnReceiveMavlink)(const CInboundMessage& message, const CByteSpan& frame) = nullptr;
+            void (*m_OnReceiveValueStream)(const CInboundMessage& message, const CValueRecord& record) = nullptr;
+            CDispatchTable<MessageHandler> m_message_handlers;
             
             std::mutex m_lock;
     };
@@ -0,0 +1,16 @@
+// Exported symbols of CModule signatures replaced by faster overloads. see DE_MODULE_BUILD_REMOVED_API
+#define DE_MODULE_BUILD_REMOVED_API
+
+#include "de_module.hpp"
+
+
+void de::comm::CModule::sendBMSG (const std::string& targetPartyID, const char * bmsg, const int bmsg_length, const int& andruav_message_id, const bool& internal_message, const Json_de& message_cmd)
+{
+    sendBMSG(std::string_view(targetPartyID), bmsg, bmsg_length, andruav_message_id, internal_message, message_cmd);
+}
+
+
+void de::comm::CModule::sendJMSG (const std::string targetPartyID, const Json_de jmsg, const int andruav_message_id, const bool internal_message)
+{
+    sendJMSG(std::string_view(targetPartyID), static_cast<const Json_de&>(jmsg), andruav_message_id, internal_message);
+}
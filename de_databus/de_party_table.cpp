@@ -0,0 +1,143 @@
+#include <algorithm>
+
+#include "de_party_table.hpp"
+
+using namespace de::comm;
+
+
+CPartyTable::CPartyTable ()
+{
+    m_parties.push_back(PARTY_ENTRY{std::string(), 0, 0, false, 1});
+    m_handles.emplace(m_parties.back().party_id, 0);
+}
+
+
+PARTY_HANDLE CPartyTable::intern (const std::string_view party_id)
+{
+    ++m_intern_count;
+
+    const std::map<std::string_view, PARTY_HANDLE>::const_iterator it = m_handles.find(party_id);
+    if (it != m_handles.end())
+    {
+        // the empty party is never evicted.
+        if (it->second != 0) m_parties[it->second].last_intern = m_intern_count;
+        return it->second;
+    }
+
+    PARTY_HANDLE party;
+    if (m_free_handles.empty())
+    {
+        party = static_cast<PARTY_HANDLE>(m_parties.size());
+        m_parties.push_back(PARTY_ENTRY());
+    }
+    else
+    {
+        party = m_free_handles.back();
+        m_free_handles.pop_back();
+    }
+
+    PARTY_ENTRY& entry = m_parties[party];
+    entry = PARTY_ENTRY{std::string(party_id), 0, 0, false, m_intern_count};
+    m_handles.emplace(entry.party_id, party);
+    return party;
+}
+
+
+std::vector<PARTY_HANDLE> CPartyTable::evict (const std::set<PARTY_HANDLE>& referenced)
+{
+    std::vector<std::pair<uint64_t, PARTY_HANDLE>> candidates;
+    for (PARTY_HANDLE party = 1; party < m_parties.size(); ++party)
+    {
+        const PARTY_ENTRY& entry = m_parties[party];
+        if ((entry.last_intern == 0) || (entry.alias != 0) || entry.frequent || (referenced.count(party) != 0)) continue;
+        candidates.emplace_back(entry.last_intern, party);
+    }
+
+    const std::size_t keep = PARTY_TABLE_MAX_PARTIES - PARTY_TABLE_MAX_PARTIES / 4;
+    const std::size_t count = (m_handles.size() > keep) ? std::min(m_handles.size() - keep, candidates.size()) : 0;
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+
+    std::vector<PARTY_HANDLE> evicted;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        PARTY_ENTRY& entry = m_parties[candidates[i].second];
+        m_handles.erase(entry.party_id);
+        entry = PARTY_ENTRY{std::string(), 0, 0, false, 0};
+        m_free_handles.push_back(candidates[i].second);
+        evicted.push_back(candidates[i].second);
+    }
+
+    return evicted;
+}
+
+
+bool CPartyTable::countUse (const PARTY_HANDLE party, const uint32_t min_uses)
+{
+    // empty target is shorter than any alias.
+    if (party == 0) return false;
+
+    PARTY_ENTRY& entry = m_parties[party];
+    if (entry.frequent) return false;
+    if (++entry.uses < min_uses) return false;
+    if (m_frequent_count >= SESSION_ALIAS_MAX_PARTIES) return false;
+
+    entry.frequent = true;
+    ++m_frequent_count;
+    return true;
+}
+
+
+Json_de CPartyTable::getFrequentParties () const
+{
+    Json_de parties = Json_de::array();
+    for (const PARTY_ENTRY& entry : m_parties)
+    {
+        if (entry.frequent) parties.push_back(entry.party_id);
+    }
+
+    return parties;
+}
+
+
+bool CPartyTable::setAliases (const Json_de& aliases)
+{
+    if (!aliases.is_object()) return clearAliases();
+
+    bool changed = false;
+    for (PARTY_ENTRY& entry : m_parties)
+    {
+        uint16_t alias = 0;
+        if (entry.frequent)
+        {
+            const Json_de::const_iterator it = aliases.find(entry.party_id);
+            if ((it != aliases.end()) && it->is_number_unsigned() && (it->get<uint64_t>() <= 0xFFFF))
+            {
+                alias = it->get<uint16_t>();
+            }
+        }
+
+        if (entry.alias != alias)
+        {
+            entry.alias = alias;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+
+bool CPartyTable::clearAliases ()
+{
+    bool changed = false;
+    for (PARTY_ENTRY& entry : m_parties)
+    {
+        if (entry.alias != 0)
+        {
+            entry.alias = 0;
+            changed = true;
+        }
+    }
+
+    return changed;
+}
@@ -0,0 +1,129 @@
+#ifndef DE_PARTY_TABLE_H_
+#define DE_PARTY_TABLE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../helpers/json_de.hpp"
+
+
+// party ids used by at least this many messages are offered for a session alias.
+#define SESSION_ALIAS_MIN_USES          16
+// at most this many party ids are offered.
+#define SESSION_ALIAS_MAX_PARTIES       64
+// parties kept before the least recently used ones are evicted. see CPartyTable::evict
+#define PARTY_TABLE_MAX_PARTIES         1024
+
+
+/**
+ * @brief interned party id. see CPartyTable
+ * @details handle 0 is always the empty party id used by group and intermodule messages.
+ */
+typedef uint32_t PARTY_HANDLE;
+
+
+/**
+ * @brief session aliases written in an envelope instead of @link INTERMODULE_MODULE_KEY @endlink
+ * and @link ANDRUAV_PROTOCOL_TARGET_ID @endlink. 0 means no alias.
+ */
+typedef struct
+{
+    uint16_t module_key;
+    uint16_t target_party;
+} SESSION_ALIASES;
+
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief interns party ids that messages are sent to.
+     * @details party ids are stored once and referred to by handle, so streams and queued messages
+     * compare and keep handles instead of string copies. Also holds the session alias of each party.
+     * Once PARTY_TABLE_MAX_PARTIES parties are interned, parties without an alias are evicted and
+     * their handles reused.
+     * not thread safe. CModule uses it while holding its lock.
+     */
+    class CPartyTable
+    {
+        public:
+
+            CPartyTable ();
+
+        public:
+
+            PARTY_HANDLE intern (const std::string_view party_id);
+
+            /**
+             * @return true if intern of a new party id should be preceded by evict().
+             */
+            inline bool isFull () const { return m_handles.size() >= PARTY_TABLE_MAX_PARTIES; }
+
+            /**
+             * @brief removes least recently interned parties until a quarter of the table is free.
+             * @details parties with an alias or offered for one are kept, so the table may stay full.
+             * @param referenced handles still held by streams or queued messages. They are kept.
+             * @return removed handles. Later intern calls reuse them.
+             */
+            std::vector<PARTY_HANDLE> evict (const std::set<PARTY_HANDLE>& referenced);
+
+            /**
+             * @details valid as long as the table exists.
+             */
+            inline std::string_view getPartyId (const PARTY_HANDLE party) const { return m_parties[party].party_id; }
+
+            inline uint16_t getAlias (const PARTY_HANDLE party) const { return m_parties[party].alias; }
+
+            /**
+             * @brief counts a message sent to party.
+             * @return true once, when party reaches min_uses and has no alias yet.
+             */
+            bool countUse (const PARTY_HANDLE party, const uint32_t min_uses);
+
+            /**
+             * @return array of party ids to be offered for aliases.
+             */
+            Json_de getFrequentParties () const;
+
+            /**
+             * @brief applies aliases assigned by communicator as {"party id": alias}.
+             * @details parties missing from aliases lose their alias.
+             * @return true if any alias changed.
+             */
+            bool setAliases (const Json_de& aliases);
+
+            /**
+             * @return true if any alias was set.
+             */
+            bool clearAliases ();
+
+        private:
+
+            typedef struct
+            {
+                std::string party_id;
+                uint32_t uses;
+                uint16_t alias;
+                bool frequent;
+                // 0 if the entry is free.
+                uint64_t last_intern;
+            } PARTY_ENTRY;
+
+            // deque keeps party_id strings in place so m_handles can refer to them.
+            std::deque<PARTY_ENTRY> m_parties;
+            std::map<std::string_view, PARTY_HANDLE> m_handles;
+            std::vector<PARTY_HANDLE> m_free_handles;
+            uint64_t m_intern_count = 0;
+            std::size_t m_frequent_count = 0;
+    };
+}
+}
+
+#endif
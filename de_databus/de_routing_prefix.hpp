@@ -0,0 +1,130 @@
+#ifndef DE_ROUTING_PREFIX_H_
+#define DE_ROUTING_PREFIX_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+#include "messages.hpp"
+#include "de_message_registry.hpp"
+
+
+/**
+ * @brief fixed size binary prefix ahead of a message.
+ * @details carries what routing, filtering and prioritizing need so they are decided
+ * with a few loads instead of scanning the JSON envelope. The envelope that follows is unchanged
+ * and remains the reference. Messages are prefixed only after the communicator accepts the
+ * offered version in its TYPE_AndruavModule_ID reply. see CModule::setRoutingPrefix
+ *
+ * Layout, little endian:
+ *  [0] ROUTING_PREFIX_MARKER. JSON text starts with '{' and encoded frames with DATABUS_FRAME_MARKER.
+ *  [1] ROUTING_PREFIX_VERSION
+ *  [2] ENUM_ROUTING_TYPE
+ *  [3] flags: ENUM_MESSAGE_PRIORITY in ROUTING_PREFIX_PRIORITY_MASK, ROUTING_PREFIX_FLAG_STATE, ROUTING_PREFIX_FLAG_TARGETED
+ *  [4] u16 message type
+ *  [6] u16 target alias or 0. see CModule::setSessionAliases
+ */
+#define ROUTING_PREFIX_MARKER           0xDF
+#define ROUTING_PREFIX_VERSION          1
+#define ROUTING_PREFIX_SIZE             8
+
+#define ROUTING_PREFIX_PRIORITY_MASK    0x03
+// message type is coalescable. see @link isMessageCoalescable @endlink
+#define ROUTING_PREFIX_FLAG_STATE       0x04
+// message has a target party. Group and intermodule messages have none.
+#define ROUTING_PREFIX_FLAG_TARGETED    0x08
+
+
+typedef enum {
+    ROUTING_TYPE_UNKNOWN        = 0,
+    ROUTING_TYPE_GROUP          = 1,
+    ROUTING_TYPE_INDIVIDUAL     = 2,
+    ROUTING_TYPE_INTERMODULE    = 3,
+    ROUTING_TYPE_SYSTEM         = 4
+} ENUM_ROUTING_TYPE;
+
+
+typedef struct
+{
+    ENUM_ROUTING_TYPE routing_type;
+    uint8_t flags;
+    uint16_t message_type;
+    uint16_t target_alias;
+} ROUTING_PREFIX;
+
+
+namespace de
+{
+namespace comm
+{
+    inline bool hasRoutingPrefix (const char * message, const std::size_t length)
+    {
+        return (length >= ROUTING_PREFIX_SIZE) && (static_cast<unsigned char>(message[0]) == ROUTING_PREFIX_MARKER);
+    }
+
+
+    inline ENUM_ROUTING_TYPE getRoutingTypeCode (const std::string_view routing_type)
+    {
+        if (routing_type == CMD_COMM_GROUP) return ROUTING_TYPE_GROUP;
+        if (routing_type == CMD_COMM_INDIVIDUAL) return ROUTING_TYPE_INDIVIDUAL;
+        if (routing_type == CMD_TYPE_INTERMODULE) return ROUTING_TYPE_INTERMODULE;
+        if (routing_type == CMD_COMM_SYSTEM) return ROUTING_TYPE_SYSTEM;
+        return ROUTING_TYPE_UNKNOWN;
+    }
+
+
+    /**
+     * @brief fills prefix of an outgoing message.
+     * @return false if message type does not fit the prefix. Such messages are sent without one.
+     */
+    inline bool makeRoutingPrefix (const int message_type, const std::string_view routing_type, const bool has_target,
+                                   const uint16_t target_alias, ROUTING_PREFIX& prefix)
+    {
+        if ((message_type < 0) || (message_type > 0xFFFF)) return false;
+
+        const CMessageTypeInfo * info = getMessageTypeInfo(message_type);
+        const ENUM_MESSAGE_PRIORITY priority = (info == nullptr) ? MESSAGE_PRIORITY_NORMAL : info->priority;
+
+        prefix.routing_type = getRoutingTypeCode(routing_type);
+        prefix.flags = static_cast<uint8_t>(priority & ROUTING_PREFIX_PRIORITY_MASK);
+        if ((info != nullptr) && info->is_coalescable) prefix.flags |= ROUTING_PREFIX_FLAG_STATE;
+        if (has_target) prefix.flags |= ROUTING_PREFIX_FLAG_TARGETED;
+        prefix.message_type = static_cast<uint16_t>(message_type);
+        prefix.target_alias = target_alias;
+        return true;
+    }
+
+
+    inline void writeRoutingPrefix (const ROUTING_PREFIX& prefix, char * out)
+    {
+        out[0] = static_cast<char>(ROUTING_PREFIX_MARKER);
+        out[1] = static_cast<char>(ROUTING_PREFIX_VERSION);
+        out[2] = static_cast<char>(prefix.routing_type);
+        out[3] = static_cast<char>(prefix.flags);
+        out[4] = static_cast<char>(prefix.message_type & 0xFF);
+        out[5] = static_cast<char>(prefix.message_type >> 8);
+        out[6] = static_cast<char>(prefix.target_alias & 0xFF);
+        out[7] = static_cast<char>(prefix.target_alias >> 8);
+    }
+
+
+    /**
+     * @return false if message has no prefix or a version this build does not know.
+     */
+    inline bool readRoutingPrefix (const char * message, const std::size_t length, ROUTING_PREFIX& prefix)
+    {
+        if (!hasRoutingPrefix(message, length)) return false;
+
+        const unsigned char * bytes = reinterpret_cast<const unsigned char *>(message);
+        if (bytes[1] != ROUTING_PREFIX_VERSION) return false;
+
+        prefix.routing_type = static_cast<ENUM_ROUTING_TYPE>(bytes[2]);
+        prefix.flags = bytes[3];
+        prefix.message_type = static_cast<uint16_t>(bytes[4] | (bytes[5] << 8));
+        prefix.target_alias = static_cast<uint16_t>(bytes[6] | (bytes[7] << 8));
+        return true;
+    }
+}
+}
+
+#endif
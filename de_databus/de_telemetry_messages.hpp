@@ -0,0 +1,209 @@
+#ifndef DE_TELEMETRY_MESSAGES_H_
+#define DE_TELEMETRY_MESSAGES_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "../helpers/json_de.hpp"
+
+#include "messages.hpp"
+#include "de_inbound_message.hpp"
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "telemetry binary codecs assume little endian hosts"
+#endif
+
+
+/**
+ * @brief Typed high rate telemetry messages.
+ * @details Each message is defined ONCE below as a list of
+ *      FIELD(c++ type, member name, JSON key)
+ * and DE_DEFINE_TELEMETRY_MESSAGE generates from that list:
+ *  - the C++ struct.
+ *  - packed little endian binary codec that travels as sendBMSG binary part.
+ *  - JSON codec that produces/accepts the legacy "ms" section for peers that do not understand binary.
+ * So the struct and its codecs cannot drift apart.
+ * Modules can define their own telemetry messages the same way.
+ *
+ * Binary layout: [TELEMETRY_CODEC_VERSION][fields in declaration order].
+ * Fields may only be appended. Decoders accept longer payloads so older modules
+ * can read messages produced by newer ones. Change TELEMETRY_CODEC_VERSION for any other change.
+ */
+#define TELEMETRY_CODEC_VERSION     1
+
+
+/**
+ * 3D: fix type.
+ * SC: satellites count.
+ * p:  gps provider. see GPS_MODE_*
+ * la: latitude in degrees.
+ * ln: longitude in degrees.
+ * a:  absolute altitude in meter.
+ * r:  relative altitude in meter.
+ * y:  yaw in cdeg.
+ */
+#define DE_TELEMETRY_GPS_FIELDS(FIELD) \
+    FIELD(uint8_t,  fix_type,               "3D")   \
+    FIELD(uint8_t,  satellites_count,       "SC")   \
+    FIELD(uint8_t,  provider,               "p")    \
+    FIELD(double,   latitude,               "la")   \
+    FIELD(double,   longitude,              "ln")   \
+    FIELD(float,    altitude,               "a")    \
+    FIELD(float,    relative_altitude,      "r")    \
+    FIELD(float,    yaw,                    "y")
+
+/**
+ * FV: battery voltage in volts.
+ * FI: battery current in amperes.
+ * FR: battery remaining in percent.
+ * T:  battery temperature in celsius.
+ * C:  consumed current in mAh.
+ */
+#define DE_TELEMETRY_POWER_FIELDS(FIELD) \
+    FIELD(float,    battery_voltage,        "FV")   \
+    FIELD(float,    battery_current,        "FI")   \
+    FIELD(int8_t,   battery_remaining,      "FR")   \
+    FIELD(float,    battery_temperature,    "T")    \
+    FIELD(float,    current_consumed,       "C")
+
+/**
+ * a: roll in radians.
+ * b: pitch in radians.
+ * y: yaw in radians.
+ * d: desired roll in degrees.
+ * e: desired pitch in degrees.
+ * f: desired heading in degrees.
+ * i: bearing to current waypoint in degrees.
+ * w: distance to active waypoint in meters.
+ * h: altitude error in meters.
+ */
+#define DE_TELEMETRY_NAV_INFO_FIELDS(FIELD) \
+    FIELD(float,    roll,                   "a")    \
+    FIELD(float,    pitch,                  "b")    \
+    FIELD(float,    yaw,                    "y")    \
+    FIELD(float,    nav_roll,               "d")    \
+    FIELD(float,    nav_pitch,              "e")    \
+    FIELD(float,    nav_bearing,            "f")    \
+    FIELD(float,    target_bearing,         "i")    \
+    FIELD(float,    wp_dist,                "w")    \
+    FIELD(float,    alt_error,              "h")
+
+/**
+ * x, y: target center in frame, normalized [0,1].
+ * w, h: target box size, normalized [0,1].
+ * c: camera direction. see TRACKING_CAMERA_DIRECTION_*
+ */
+#define DE_TELEMETRY_TRACKING_TARGET_LOCATION_FIELDS(FIELD) \
+    FIELD(float,    x,                      "x")    \
+    FIELD(float,    y,                      "y")    \
+    FIELD(float,    width,                  "w")    \
+    FIELD(float,    height,                 "h")    \
+    FIELD(uint8_t,  camera_direction,       "c")
+
+
+
+#define DE_TELEMETRY_FIELD_DECLARE(type, name, key)     type name = 0;
+#define DE_TELEMETRY_FIELD_SIZE(type, name, key)        + sizeof(type)
+#define DE_TELEMETRY_FIELD_ENCODE(type, name, key)      std::memcpy(out, &name, sizeof(type)); out += sizeof(type);
+#define DE_TELEMETRY_FIELD_DECODE(type, name, key)      std::memcpy(&name, in, sizeof(type)); in += sizeof(type);
+#define DE_TELEMETRY_FIELD_TO_JSON(type, name, key)     json[key] = name;
+#define DE_TELEMETRY_FIELD_FROM_JSON(type, name, key)   if (json.contains(key) && json[key].is_number()) name = json[key].get<type>();
+
+#define DE_DEFINE_TELEMETRY_MESSAGE(class_name, message_type, FIELDS)                       \
+    struct class_name                                                                       \
+    {                                                                                       \
+        static constexpr int MESSAGE_TYPE = message_type;                                   \
+        static constexpr std::size_t BINARY_SIZE = 1 FIELDS(DE_TELEMETRY_FIELD_SIZE);       \
+                                                                                            \
+        FIELDS(DE_TELEMETRY_FIELD_DECLARE)                                                  \
+                                                                                            \
+        void encode (char * out) const                                                      \
+        {                                                                                   \
+            *out++ = TELEMETRY_CODEC_VERSION;                                               \
+            FIELDS(DE_TELEMETRY_FIELD_ENCODE)                                               \
+        }                                                                                   \
+                                                                                            \
+        bool decode (const char * in, const std::size_t length)                             \
+        {                                                                                   \
+            if ((length < BINARY_SIZE) || (*in != TELEMETRY_CODEC_VERSION)) return false;   \
+            ++in;                                                                           \
+            FIELDS(DE_TELEMETRY_FIELD_DECODE)                                               \
+            return true;                                                                    \
+        }                                                                                   \
+                                                                                            \
+        Json_de toJson () const                                                             \
+        {                                                                                   \
+            Json_de json;                                                                   \
+            FIELDS(DE_TELEMETRY_FIELD_TO_JSON)                                              \
+            return json;                                                                    \
+        }                                                                                   \
+                                                                                            \
+        void fromJson (const Json_de& json)                                                 \
+        {                                                                                   \
+            FIELDS(DE_TELEMETRY_FIELD_FROM_JSON)                                            \
+        }                                                                                   \
+    };
+
+
+namespace de
+{
+namespace comm
+{
+    DE_DEFINE_TELEMETRY_MESSAGE(CTelemetryGPS,                      TYPE_AndruavMessage_GPS,                    DE_TELEMETRY_GPS_FIELDS)
+    DE_DEFINE_TELEMETRY_MESSAGE(CTelemetryPower,                    TYPE_AndruavMessage_POWER,                  DE_TELEMETRY_POWER_FIELDS)
+    DE_DEFINE_TELEMETRY_MESSAGE(CTelemetryNavInfo,                  TYPE_AndruavMessage_NAV_INFO,               DE_TELEMETRY_NAV_INFO_FIELDS)
+    DE_DEFINE_TELEMETRY_MESSAGE(CTelemetryTrackingTargetLocation,   TYPE_AndruavMessage_TrackingTargetLocation, DE_TELEMETRY_TRACKING_TARGET_LOCATION_FIELDS)
+
+
+    /**
+     * @brief reads typed telemetry from a received message.
+     * @details binary messages are decoded by the binary codec. Text messages from
+     * legacy peers are decoded from "ms" section.
+     * @return false if message is not of telemetry type T or is malformed.
+     */
+    template <typename T>
+    bool decodeTelemetry (const Json_de& andruav_message, const CByteSpan& binary_payload, T& telemetry)
+    {
+        if (!andruav_message.contains(ANDRUAV_PROTOCOL_MESSAGE_TYPE)) return false;
+        if (andruav_message[ANDRUAV_PROTOCOL_MESSAGE_TYPE] != T::MESSAGE_TYPE) return false;
+
+        if (binary_payload.data() != nullptr)
+        {
+            return telemetry.decode(binary_payload.data(), binary_payload.size());
+        }
+
+        if (!andruav_message.contains(ANDRUAV_PROTOCOL_MESSAGE_CMD)) return false;
+        const Json_de& cmd = andruav_message[ANDRUAV_PROTOCOL_MESSAGE_CMD];
+        if (!cmd.is_object()) return false;
+
+        telemetry.fromJson(cmd);
+        return true;
+    }
+
+
+    /**
+     * @brief reads typed telemetry from a message received by the lazy CModule callback.
+     * @details binary messages are decoded without building a JSON DOM.
+     */
+    template <typename T>
+    bool decodeTelemetry (const CInboundMessage& message, T& telemetry)
+    {
+        if (message.getEnvelope().getMessageType() != T::MESSAGE_TYPE) return false;
+
+        if (message.isBinary())
+        {
+            const CByteSpan binary_payload = message.getBinaryPayload();
+            return telemetry.decode(binary_payload.data(), binary_payload.size());
+        }
+
+        const Json_de& cmd = message.getCmd();
+        if (!cmd.is_object()) return false;
+
+        telemetry.fromJson(cmd);
+        return true;
+    }
+}
+}
+
+#endif
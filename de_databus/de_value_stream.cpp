@@ -0,0 +1,190 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "de_value_stream.hpp"
+
+using namespace de::comm;
+
+
+// descriptor JSON keys
+#define DESCRIPTOR_STREAM_ID    "i"
+#define DESCRIPTOR_FIELDS       "f"
+
+
+static std::size_t getFieldSize (const ENUM_VALUE_FIELD_TYPE type)
+{
+    switch (type)
+    {
+        case VALUE_FIELD_INT8:
+        case VALUE_FIELD_UINT8:     return 1;
+        case VALUE_FIELD_INT16:
+        case VALUE_FIELD_UINT16:    return 2;
+        case VALUE_FIELD_INT32:
+        case VALUE_FIELD_UINT32:
+        case VALUE_FIELD_FLOAT32:   return 4;
+        case VALUE_FIELD_FLOAT64:   return 8;
+        default:                    return 0;
+    }
+}
+
+
+template <typename T>
+static inline void packInteger (double value, char * out)
+{
+    value = std::round(value);
+    if (!(value >= static_cast<double>(std::numeric_limits<T>::min()))) value = std::numeric_limits<T>::min();
+    if (value > static_cast<double>(std::numeric_limits<T>::max())) value = std::numeric_limits<T>::max();
+
+    const T field = static_cast<T>(value);
+    std::memcpy(out, &field, sizeof(T));
+}
+
+
+template <typename T>
+static inline double unpackField (const char * in)
+{
+    T field;
+    std::memcpy(&field, in, sizeof(T));
+    return static_cast<double>(field);
+}
+
+
+CValueStreamDescriptor::CValueStreamDescriptor (const uint16_t stream_id, const std::vector<VALUE_FIELD>& fields)
+    : m_stream_id(stream_id), m_fields(fields)
+{
+    updateLayout();
+}
+
+
+void CValueStreamDescriptor::updateLayout ()
+{
+    m_offsets.clear();
+    m_record_size = 0;
+    for (const VALUE_FIELD& field : m_fields)
+    {
+        m_offsets.push_back(m_record_size);
+        m_record_size += getFieldSize(field.type);
+    }
+}
+
+
+int CValueStreamDescriptor::getFieldIndex (const std::string_view name) const
+{
+    for (std::size_t i = 0; i < m_fields.size(); ++i)
+    {
+        if (m_fields[i].name == name) return static_cast<int>(i);
+    }
+
+    return -1;
+}
+
+
+void CValueStreamDescriptor::pack (const double * values, char * record) const
+{
+    for (std::size_t i = 0; i < m_fields.size(); ++i)
+    {
+        const VALUE_FIELD& field = m_fields[i];
+        const double value = values[i] / field.scale;
+        char * out = record + m_offsets[i];
+
+        switch (field.type)
+        {
+            case VALUE_FIELD_INT8:      packInteger<int8_t>(value, out); break;
+            case VALUE_FIELD_UINT8:     packInteger<uint8_t>(value, out); break;
+            case VALUE_FIELD_INT16:     packInteger<int16_t>(value, out); break;
+            case VALUE_FIELD_UINT16:    packInteger<uint16_t>(value, out); break;
+            case VALUE_FIELD_INT32:     packInteger<int32_t>(value, out); break;
+            case VALUE_FIELD_UINT32:    packInteger<uint32_t>(value, out); break;
+            case VALUE_FIELD_FLOAT32:
+                {
+                    const float field_value = static_cast<float>(value);
+                    std::memcpy(out, &field_value, sizeof(float));
+                }
+                break;
+            case VALUE_FIELD_FLOAT64:
+                std::memcpy(out, &value, sizeof(double));
+                break;
+        }
+    }
+}
+
+
+double CValueStreamDescriptor::unpack (const char * record, const std::size_t field_index) const
+{
+    const VALUE_FIELD& field = m_fields[field_index];
+    const char * in = record + m_offsets[field_index];
+
+    double value = 0;
+    switch (field.type)
+    {
+        case VALUE_FIELD_INT8:      value = unpackField<int8_t>(in); break;
+        case VALUE_FIELD_UINT8:     value = unpackField<uint8_t>(in); break;
+        case VALUE_FIELD_INT16:     value = unpackField<int16_t>(in); break;
+        case VALUE_FIELD_UINT16:    value = unpackField<uint16_t>(in); break;
+        case VALUE_FIELD_INT32:     value = unpackField<int32_t>(in); break;
+        case VALUE_FIELD_UINT32:    value = unpackField<uint32_t>(in); break;
+        case VALUE_FIELD_FLOAT32:   value = unpackField<float>(in); break;
+        case VALUE_FIELD_FLOAT64:   value = unpackField<double>(in); break;
+    }
+
+    return value * field.scale;
+}
+
+
+/**
+ * @brief {"i": stream_id, "f": [[name, type, scale], ...]}
+ */
+Json_de CValueStreamDescriptor::toJson () const
+{
+    Json_de fields = Json_de::array();
+    for (const VALUE_FIELD& field : m_fields)
+    {
+        fields.push_back(Json_de::array({field.name, static_cast<int>(field.type), field.scale}));
+    }
+
+    Json_de json;
+    json[DESCRIPTOR_STREAM_ID] = m_stream_id;
+    json[DESCRIPTOR_FIELDS] = std::move(fields);
+    return json;
+}
+
+
+bool CValueStreamDescriptor::fromJson (const Json_de& json)
+{
+    if (!json.is_object()) return false;
+    if (!json.contains(DESCRIPTOR_STREAM_ID) || !json[DESCRIPTOR_STREAM_ID].is_number_unsigned()) return false;
+    if (json[DESCRIPTOR_STREAM_ID].get<uint64_t>() > 0xFFFF) return false;
+    if (!json.contains(DESCRIPTOR_FIELDS) || !json[DESCRIPTOR_FIELDS].is_array()) return false;
+
+    std::vector<VALUE_FIELD> fields;
+    for (const Json_de& field : json[DESCRIPTOR_FIELDS])
+    {
+        if (!field.is_array() || (field.size() != 3)) return false;
+        if (!field[0].is_string() || !field[1].is_number_integer() || !field[2].is_number()) return false;
+
+        const int type = field[1].get<int>();
+        if ((type < VALUE_FIELD_INT8) || (type > VALUE_FIELD_FLOAT64)) return false;
+
+        const double scale = field[2].get<double>();
+        if (!(scale != 0) || !std::isfinite(scale)) return false;
+
+        fields.push_back(VALUE_FIELD{field[0].get<std::string>(), static_cast<ENUM_VALUE_FIELD_TYPE>(type), scale});
+    }
+
+    if (fields.empty()) return false;
+
+    m_stream_id = json[DESCRIPTOR_STREAM_ID].get<uint16_t>();
+    m_fields = std::move(fields);
+    updateLayout();
+    return true;
+}
+
+
+double CValueRecord::getValue (const std::string_view name) const
+{
+    const int field_index = m_descriptor.getFieldIndex(name);
+    if (field_index < 0) return std::numeric_limits<double>::quiet_NaN();
+
+    return m_descriptor.unpack(m_record, field_index);
+}
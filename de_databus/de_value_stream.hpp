@@ -0,0 +1,152 @@
+#ifndef DE_VALUE_STREAM_H_
+#define DE_VALUE_STREAM_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../helpers/json_de.hpp"
+
+
+/**
+ * @brief "ms" fields of a value stream batch.
+ * @details batch is a binary message whose binary part is packed records.
+ * VALUE_STREAM_ID identifies the stream and VALUE_STREAM_DESCRIPTOR carries
+ * the stream layout in the first batch and then every VALUE_STREAM_DESCRIPTOR_PERIOD_MS.
+ */
+#define VALUE_STREAM_ID                         "vs"
+#define VALUE_STREAM_DESCRIPTOR                 "vd"
+
+#define VALUE_STREAM_DESCRIPTOR_PERIOD_MS       5000
+
+// receiver forgets all descriptors when it knows more than this. They are learned again from the next batches.
+#define VALUE_STREAM_MAX_DESCRIPTORS            256
+
+
+typedef enum {
+    VALUE_FIELD_INT8        = 0,
+    VALUE_FIELD_UINT8       = 1,
+    VALUE_FIELD_INT16       = 2,
+    VALUE_FIELD_UINT16      = 3,
+    VALUE_FIELD_INT32       = 4,
+    VALUE_FIELD_UINT32      = 5,
+    VALUE_FIELD_FLOAT32     = 6,
+    VALUE_FIELD_FLOAT64     = 7
+} ENUM_VALUE_FIELD_TYPE;
+
+
+typedef struct
+{
+    std::string name;
+    ENUM_VALUE_FIELD_TYPE type;
+    // field carries value / scale. e.g. 0.01 stores 12.34 as 1234 in an integer field.
+    double scale;
+} VALUE_FIELD;
+
+
+typedef struct
+{
+    // sender side
+    uint64_t records_sent;
+    uint64_t batches_sent;
+    uint64_t descriptors_sent;
+    // receiver side
+    uint64_t records_received;
+    // dropped because their descriptor was not received yet or batch was malformed.
+    uint64_t batches_dropped;
+} VALUE_STREAM_COUNTERS;
+
+
+namespace de
+{
+namespace comm
+{
+    /**
+     * @brief layout of the records of a value stream.
+     * @details records are fields packed in declaration order without padding,
+     * in host byte order like the telemetry codec.
+     * Integer fields are rounded and clamped to their range.
+     */
+    class CValueStreamDescriptor
+    {
+        public:
+
+            CValueStreamDescriptor () = default;
+            CValueStreamDescriptor (const uint16_t stream_id, const std::vector<VALUE_FIELD>& fields);
+
+        public:
+
+            inline uint16_t getStreamId () const { return m_stream_id; }
+            inline const std::vector<VALUE_FIELD>& getFields () const { return m_fields; }
+            inline std::size_t getFieldCount () const { return m_fields.size(); }
+            inline std::size_t getRecordSize () const { return m_record_size; }
+
+            /**
+             * @return index of field or -1 if there is no such field.
+             */
+            int getFieldIndex (const std::string_view name) const;
+
+            /**
+             * @param values one value per field.
+             * @param record getRecordSize() bytes.
+             */
+            void pack (const double * values, char * record) const;
+
+            double unpack (const char * record, const std::size_t field_index) const;
+
+            Json_de toJson () const;
+
+            /**
+             * @return false if json is not a valid descriptor.
+             */
+            bool fromJson (const Json_de& json);
+
+        private:
+
+            void updateLayout ();
+
+        private:
+
+            uint16_t m_stream_id = 0;
+            std::vector<VALUE_FIELD> m_fields;
+            std::vector<std::size_t> m_offsets;
+            std::size_t m_record_size = 0;
+    };
+
+
+    /**
+     * @brief one received record of a value stream.
+     * @details valid only during the stream handler call.
+     */
+    class CValueRecord
+    {
+        public:
+
+            CValueRecord (const CValueStreamDescriptor& descriptor, const char * record)
+                : m_descriptor(descriptor), m_record(record) {}
+
+        public:
+
+            inline const CValueStreamDescriptor& getDescriptor () const { return m_descriptor; }
+
+            /**
+             * @brief scaled value of a field.
+             */
+            inline double getValue (const std::size_t field_index) const { return m_descriptor.unpack(m_record, field_index); }
+
+            /**
+             * @return NaN if there is no such field.
+             */
+            double getValue (const std::string_view name) const;
+
+        private:
+
+            const CValueStreamDescriptor& m_descriptor;
+            const char * m_record;
+    };
+}
+}
+
+#endif
@@ -0,0 +1,415 @@
+#include <cstring>
+
+#ifdef DE_ENABLE_LZ4
+#include <lz4.h>
+#endif
+
+#include "messages.hpp"
+#include "de_json_writer.hpp"
+#include "de_wire_encoding.hpp"
+
+using namespace de::comm;
+
+
+const char * de::comm::getEncodingName (const ENUM_DATABUS_ENCODING encoding)
+{
+    switch (encoding)
+    {
+        case DATABUS_ENCODING_CBOR:     return DATABUS_ENCODING_NAME_CBOR;
+        case DATABUS_ENCODING_MSGPACK:  return DATABUS_ENCODING_NAME_MSGPACK;
+        default:                        return "json";
+    }
+}
+
+
+ENUM_DATABUS_ENCODING de::comm::getEncodingByName (const std::string_view name)
+{
+    if (name == DATABUS_ENCODING_NAME_CBOR) return DATABUS_ENCODING_CBOR;
+    if (name == DATABUS_ENCODING_NAME_MSGPACK) return DATABUS_ENCODING_MSGPACK;
+    return DATABUS_ENCODING_JSON;
+}
+
+
+static inline void appendBigEndian (std::string& out, const uint64_t value, const int bytes)
+{
+    for (int i = bytes - 1; i >= 0; --i)
+    {
+        out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+
+/**
+ * @brief CBOR head: major type and argument in shortest form.
+ */
+static void appendCborHead (std::string& out, const uint8_t major_type, const uint64_t argument)
+{
+    const uint8_t major = static_cast<uint8_t>(major_type << 5);
+    if (argument < 24)
+    {
+        out.push_back(static_cast<char>(major | argument));
+    }
+    else if (argument <= 0xFF)
+    {
+        out.push_back(static_cast<char>(major | 24));
+        appendBigEndian(out, argument, 1);
+    }
+    else if (argument <= 0xFFFF)
+    {
+        out.push_back(static_cast<char>(major | 25));
+        appendBigEndian(out, argument, 2);
+    }
+    else if (argument <= 0xFFFFFFFF)
+    {
+        out.push_back(static_cast<char>(major | 26));
+        appendBigEndian(out, argument, 4);
+    }
+    else
+    {
+        out.push_back(static_cast<char>(major | 27));
+        appendBigEndian(out, argument, 8);
+    }
+}
+
+
+static void appendMapHeader (std::string& out, const ENUM_DATABUS_ENCODING encoding, const uint8_t count)
+{
+    if (encoding == DATABUS_ENCODING_CBOR)
+    {
+        appendCborHead(out, 5, count);
+    }
+    else
+    {
+        // fixmap. envelopes never have more than 15 fields.
+        out.push_back(static_cast<char>(0x80 | count));
+    }
+}
+
+
+static void appendArrayHeader (std::string& out, const ENUM_DATABUS_ENCODING encoding, const uint8_t count)
+{
+    if (encoding == DATABUS_ENCODING_CBOR)
+    {
+        appendCborHead(out, 4, count);
+    }
+    else
+    {
+        // fixarray
+        out.push_back(static_cast<char>(0x90 | count));
+    }
+}
+
+
+static void appendString (std::string& out, const ENUM_DATABUS_ENCODING encoding, const std::string_view value)
+{
+    const std::size_t length = value.length();
+    if (encoding == DATABUS_ENCODING_CBOR)
+    {
+        appendCborHead(out, 3, length);
+    }
+    else if (length < 32)
+    {
+        out.push_back(static_cast<char>(0xA0 | length));
+    }
+    else if (length <= 0xFF)
+    {
+        out.push_back(static_cast<char>(0xD9));
+        appendBigEndian(out, length, 1);
+    }
+    else if (length <= 0xFFFF)
+    {
+        out.push_back(static_cast<char>(0xDA));
+        appendBigEndian(out, length, 2);
+    }
+    else
+    {
+        out.push_back(static_cast<char>(0xDB));
+        appendBigEndian(out, length, 4);
+    }
+
+    out.append(value);
+}
+
+
+static void appendInteger (std::string& out, const ENUM_DATABUS_ENCODING encoding, const int value)
+{
+    if (encoding == DATABUS_ENCODING_CBOR)
+    {
+        if (value >= 0) appendCborHead(out, 0, static_cast<uint64_t>(value));
+        else appendCborHead(out, 1, static_cast<uint64_t>(-1 - static_cast<int64_t>(value)));
+        return ;
+    }
+
+    if ((value >= 0) && (value < 128))
+    {
+        out.push_back(static_cast<char>(value));
+    }
+    else if ((value < 0) && (value >= -32))
+    {
+        out.push_back(static_cast<char>(value));
+    }
+    else
+    {
+        // int32 keeps the encoder simple. message types fit in it.
+        out.push_back(static_cast<char>(0xD2));
+        appendBigEndian(out, static_cast<uint32_t>(value), 4);
+    }
+}
+
+
+/**
+ * @brief appends nlohmann encoding of value to out.
+ * @details nlohmann writes to the end of a std::string output, so value is encoded in place.
+ */
+static void appendValue (std::string& out, const ENUM_DATABUS_ENCODING encoding, const Json_de& value)
+{
+    if (encoding == DATABUS_ENCODING_CBOR)
+    {
+        Json_de::to_cbor(value, out);
+    }
+    else
+    {
+        Json_de::to_msgpack(value, out);
+    }
+}
+
+
+static inline void writeEnvelopeLength (std::string& frame, const uint32_t envelope_length)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        frame[2 + i] = static_cast<char>((envelope_length >> (i * 8)) & 0xFF);
+    }
+}
+
+
+void de::comm::serializeEncodedMessage (std::string& out, const ENUM_DATABUS_ENCODING encoding,
+                                        const std::string_view module_key, const int andruav_message_id,
+                                        const std::string_view target_party_id, const std::string_view routing_type,
+                                        const Json_de& message_cmd, const DELTA_HEADER * delta_header,
+                                        const SESSION_ALIASES * aliases)
+{
+    out.clear();
+    out.push_back(static_cast<char>(DATABUS_FRAME_MARKER));
+    out.push_back(static_cast<char>(encoding));
+    out.append(4, '\0');
+
+    appendMapHeader(out, encoding, (delta_header == nullptr) ? 5 : 6);
+    if ((aliases != nullptr) && (aliases->module_key != 0))
+    {
+        appendString(out, encoding, INTERMODULE_MODULE_KEY_ALIAS);
+        appendInteger(out, encoding, aliases->module_key);
+    }
+    else
+    {
+        appendString(out, encoding, INTERMODULE_MODULE_KEY);
+        appendString(out, encoding, module_key);
+    }
+    appendString(out, encoding, ANDRUAV_PROTOCOL_MESSAGE_TYPE);
+    appendInteger(out, encoding, andruav_message_id);
+    if ((aliases != nullptr) && (aliases->target_party != 0))
+    {
+        appendString(out, encoding, INTERMODULE_TARGET_ID_ALIAS);
+        appendInteger(out, encoding, aliases->target_party);
+    }
+    else
+    {
+        appendString(out, encoding, ANDRUAV_PROTOCOL_TARGET_ID);
+        appendString(out, encoding, target_party_id);
+    }
+    appendString(out, encoding, INTERMODULE_ROUTING_TYPE);
+    appendString(out, encoding, routing_type);
+    appendString(out, encoding, ANDRUAV_PROTOCOL_MESSAGE_CMD);
+    appendValue(out, encoding, message_cmd);
+
+    if (delta_header != nullptr)
+    {
+        appendString(out, encoding, INTERMODULE_DELTA_HEADER);
+        appendArrayHeader(out, encoding, delta_header->keyframe ? 1 : 2);
+        appendInteger(out, encoding, delta_header->sequence);
+        if (!delta_header->keyframe) appendInteger(out, encoding, delta_header->base_sequence);
+    }
+
+    writeEnvelopeLength(out, static_cast<uint32_t>(out.length() - DATABUS_FRAME_HEADER_SIZE));
+}
+
+
+bool de::comm::compressFrame (std::string& message, const CDictionaryCodec& codec, const std::size_t min_size)
+{
+    if (message.length() < min_size) return false;
+
+    const bool is_frame = isEncodedFrame(message.data(), message.length());
+    const std::size_t envelope_offset = is_frame ? DATABUS_FRAME_HEADER_SIZE : 0;
+    const char encoding = is_frame ? message[1] : static_cast<char>(DATABUS_ENCODING_JSON);
+
+    static thread_local std::string frame;
+    frame.clear();
+    frame.push_back(static_cast<char>(DATABUS_FRAME_MARKER));
+    frame.push_back(static_cast<char>(encoding | DATABUS_FRAME_FLAG_DICTIONARY));
+    frame.append(4, '\0');
+
+    if (!codec.compress(message.data() + envelope_offset, message.length() - envelope_offset, frame)) return false;
+    if (frame.length() >= message.length()) return false;
+
+    writeEnvelopeLength(frame, static_cast<uint32_t>(frame.length() - DATABUS_FRAME_HEADER_SIZE));
+    // message keeps the compressed frame and frame keeps the old buffer for next time.
+    message.swap(frame);
+    return true;
+}
+
+
+static inline uint32_t readLittleEndian32 (const char * data)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (i * 8);
+    }
+    return value;
+}
+
+
+static inline void appendLittleEndian32 (std::string& out, const uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+    }
+}
+
+
+bool de::comm::appendCompressedPayload (std::string& message, const char * payload, const std::size_t length)
+{
+#ifdef DE_ENABLE_LZ4
+    if ((length == 0) || (length > LZ4_PAYLOAD_MAX_SIZE)) return false;
+
+    static thread_local std::string compressed;
+
+    if (length > 4 * LZ4_PAYLOAD_SAMPLE_SIZE)
+    {
+        // encoded media barely shrinks. Deciding on a sample avoids compressing all of it for nothing.
+        compressed.resize(LZ4_compressBound(LZ4_PAYLOAD_SAMPLE_SIZE));
+        const int sample_size = LZ4_compress_default(payload, &compressed[0], LZ4_PAYLOAD_SAMPLE_SIZE, static_cast<int>(compressed.size()));
+        if ((sample_size <= 0) || (sample_size > LZ4_PAYLOAD_SAMPLE_SIZE - LZ4_PAYLOAD_SAMPLE_SIZE / 16)) return false;
+    }
+
+    compressed.resize(LZ4_compressBound(static_cast<int>(length)));
+    const int compressed_size = LZ4_compress_default(payload, &compressed[0], static_cast<int>(length), static_cast<int>(compressed.size()));
+    // 8 bytes of sizes must be paid back.
+    if ((compressed_size <= 0) || (static_cast<std::size_t>(compressed_size) + 8 >= length)) return false;
+
+    if (!isEncodedFrame(message.data(), message.length()))
+    {
+        std::string header;
+        header.push_back(static_cast<char>(DATABUS_FRAME_MARKER));
+        header.push_back(static_cast<char>(DATABUS_ENCODING_JSON));
+        header.append(4, '\0');
+        writeEnvelopeLength(header, static_cast<uint32_t>(message.length()));
+        message.insert(0, header);
+    }
+
+    message[1] = static_cast<char>(message[1] | DATABUS_FRAME_FLAG_LZ4_PAYLOAD);
+    message.reserve(message.length() + 9 + compressed_size);
+    message.push_back('\0');
+    appendLittleEndian32(message, static_cast<uint32_t>(length));
+    appendLittleEndian32(message, static_cast<uint32_t>(compressed_size));
+    message.append(compressed.data(), compressed_size);
+    return true;
+#else
+    (void)message;
+    (void)payload;
+    (void)length;
+    return false;
+#endif
+}
+
+
+/**
+ * @brief appends rest of a frame to text, decompressing the binary part if it is LZ4 compressed.
+ */
+static bool appendFrameRest (std::string& text, const uint8_t flags, const char * rest, const char * end)
+{
+    if ((flags & DATABUS_FRAME_FLAG_LZ4_PAYLOAD) == 0)
+    {
+        text.append(rest, end - rest);
+        return true;
+    }
+
+#ifdef DE_ENABLE_LZ4
+    if ((end - rest < 9) || (rest[0] != 0)) return false;
+
+    const uint32_t original_size = readLittleEndian32(rest + 1);
+    const uint32_t compressed_size = readLittleEndian32(rest + 5);
+    const char * const block = rest + 9;
+    if ((original_size > LZ4_PAYLOAD_MAX_SIZE) || (compressed_size > static_cast<std::size_t>(end - block))) return false;
+
+    const std::size_t offset = text.length() + 1;
+    text.resize(offset + original_size, '\0');
+    const int size = LZ4_decompress_safe(block, &text[offset], static_cast<int>(compressed_size), static_cast<int>(original_size));
+    if ((size < 0) || (static_cast<uint32_t>(size) != original_size)) return false;
+
+    // anything after the block, i.e. the 0 appended by CUDPClient.
+    text.append(block + compressed_size, end - (block + compressed_size));
+    return true;
+#else
+    (void)text;
+    (void)rest;
+    (void)end;
+    return false;
+#endif
+}
+
+
+bool de::comm::decodeFrame (const char * message, const std::size_t length, std::string& text, Json_de * json, const CDictionaryCodec * codec)
+{
+    if (!isEncodedFrame(message, length)) return false;
+
+    const uint8_t flags = static_cast<uint8_t>(message[1]);
+    const ENUM_DATABUS_ENCODING encoding = static_cast<ENUM_DATABUS_ENCODING>(flags & DATABUS_FRAME_ENCODING_MASK);
+
+    const uint32_t envelope_length = readLittleEndian32(message + 2);
+    if (envelope_length > length - DATABUS_FRAME_HEADER_SIZE) return false;
+
+    const char * envelope = message + DATABUS_FRAME_HEADER_SIZE;
+    const char * const rest = envelope + envelope_length;
+    const char * envelope_end = rest;
+
+    if ((flags & DATABUS_FRAME_FLAG_DICTIONARY) != 0)
+    {
+        if (codec == nullptr) return false;
+
+        static thread_local std::string decompressed;
+        decompressed.clear();
+        if (!codec->decompress(envelope, envelope_length, decompressed)) return false;
+
+        envelope = decompressed.data();
+        envelope_end = envelope + decompressed.length();
+    }
+
+    Json_de decoded;
+    switch (encoding)
+    {
+        case DATABUS_ENCODING_JSON:
+            // only compressed frames carry JSON. The text is used as is.
+            if ((flags & (DATABUS_FRAME_FLAG_DICTIONARY | DATABUS_FRAME_FLAG_LZ4_PAYLOAD)) == 0) return false;
+            text.assign(envelope, envelope_end - envelope);
+            return appendFrameRest(text, flags, rest, message + length);
+        case DATABUS_ENCODING_CBOR:
+            decoded = Json_de::from_cbor(envelope, envelope_end);
+            break;
+        case DATABUS_ENCODING_MSGPACK:
+            decoded = Json_de::from_msgpack(envelope, envelope_end);
+            break;
+        default:
+            return false;
+    }
+
+    if (!decoded.is_object()) return false;
+
+    text.clear();
+    appendJson(text, decoded);
+    if (!appendFrameRest(text, flags, rest, message + length)) return false;
+
+    if (json != nullptr) *json = std::move(decoded);
+    return true;
+}
@@ -0,0 +1,117 @@
+#ifndef DE_WIRE_ENCODING_H_
+#define DE_WIRE_ENCODING_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "../helpers/json_de.hpp"
+
+#include "de_dictionary_codec.hpp"
+#include "de_delta_codec.hpp"
+#include "de_party_table.hpp"
+
+
+typedef enum {
+    DATABUS_ENCODING_JSON       = 0,
+    DATABUS_ENCODING_CBOR       = 1,
+    DATABUS_ENCODING_MSGPACK    = 2
+} ENUM_DATABUS_ENCODING;
+
+
+/**
+ * @brief first byte of an encoded frame.
+ * @details JSON messages always start with '{' so frames and JSON text can share the databus.
+ *
+ * Frame layout:
+ *  [DATABUS_FRAME_MARKER][ENUM_DATABUS_ENCODING | flags][u32 LE envelope length][envelope][rest]
+ * envelope holds the same fields as the JSON envelope including "ms".
+ * rest is exactly what follows the JSON text of an unencoded message,
+ * i.e. empty for text messages or 0 followed by the binary part for binary messages.
+ *
+ * DATABUS_FRAME_FLAG_DICTIONARY: envelope is compressed with the negotiated dictionary. see CDictionaryCodec
+ * DATABUS_FRAME_FLAG_LZ4_PAYLOAD: binary part is LZ4 compressed and rest is
+ *      [0][u32 LE original size][u32 LE compressed size][LZ4 block]. Needs DE_ENABLE_LZ4.
+ * A frame carries DATABUS_ENCODING_JSON only when one of the flags is set.
+ */
+#define DATABUS_FRAME_MARKER            0xDE
+#define DATABUS_FRAME_HEADER_SIZE       6
+#define DATABUS_FRAME_FLAG_DICTIONARY   0x80
+#define DATABUS_FRAME_FLAG_LZ4_PAYLOAD  0x40
+#define DATABUS_FRAME_ENCODING_MASK     0x0F
+
+#define DATABUS_PAYLOAD_COMPRESSION_NAME_LZ4    "lz4"
+
+// payloads above this size are compressed only if a sample of them compresses.
+#define LZ4_PAYLOAD_SAMPLE_SIZE         4096
+// decompressed payload size limit. Larger payloads are rejected.
+#define LZ4_PAYLOAD_MAX_SIZE            (16 * 1024 * 1024)
+
+#define DATABUS_ENCODING_NAME_CBOR      "cbor"
+#define DATABUS_ENCODING_NAME_MSGPACK   "msgpack"
+
+
+namespace de
+{
+namespace comm
+{
+    inline bool isEncodedFrame (const char * message, const std::size_t length)
+    {
+        return (length >= DATABUS_FRAME_HEADER_SIZE) && (static_cast<unsigned char>(message[0]) == DATABUS_FRAME_MARKER);
+    }
+
+    const char * getEncodingName (const ENUM_DATABUS_ENCODING encoding);
+
+    /**
+     * @return DATABUS_ENCODING_JSON for unknown names.
+     */
+    ENUM_DATABUS_ENCODING getEncodingByName (const std::string_view name);
+
+
+    /**
+     * @brief writes envelope of an encoded frame.
+     * @details envelope keys are written in the same order as the JSON envelope.
+     * Primitive fields are written directly, only message_cmd goes through nlohmann encoder.
+     * @param out cleared then filled with frame header and envelope.
+     * @param delta_header written as @link INTERMODULE_DELTA_HEADER @endlink if not null.
+     * @param aliases non zero aliases replace module_key and target_party_id.
+     */
+    void serializeEncodedMessage (std::string& out, const ENUM_DATABUS_ENCODING encoding,
+                                  const std::string_view module_key, const int andruav_message_id,
+                                  const std::string_view target_party_id, const std::string_view routing_type,
+                                  const Json_de& message_cmd, const DELTA_HEADER * delta_header = nullptr,
+                                  const SESSION_ALIASES * aliases = nullptr);
+
+    /**
+     * @brief compresses a serialized message envelope with a dictionary.
+     * @param message JSON text or encoded frame without the rest part. Replaced by a compressed frame
+     * when it is at least min_size bytes and compression makes it smaller.
+     * @return true if message was compressed.
+     */
+    bool compressFrame (std::string& message, const CDictionaryCodec& codec, const std::size_t min_size);
+
+    /**
+     * @brief appends binary part of a message compressed with LZ4 and flags the frame.
+     * @details JSON text is wrapped in a frame first. Already encoded data such as JPEG is detected
+     * on a sample and skipped before compressing all of it.
+     * @param message serialized envelope, JSON text or frame, without the binary part.
+     * @return false if payload does not compress or LZ4 support is not built in. message is unchanged then.
+     */
+    bool appendCompressedPayload (std::string& message, const char * payload, const std::size_t length);
+
+    /**
+     * @brief converts an encoded frame back to a JSON message followed by the rest of the frame.
+     * @details received frames are transcoded once at ingress so envelope scanning,
+     * handlers and forwarding only ever see JSON text.
+     * @param json optional. receives the decoded DOM so it does not need to be parsed from text again.
+     * Left null when the envelope was JSON text.
+     * @param codec dictionary for compressed frames. nullptr if none was offered.
+     * @return false if frame is malformed. Decoder errors are thrown as nlohmann parse_error.
+     */
+    bool decodeFrame (const char * message, const std::size_t length, std::string& text,
+                      Json_de * json = nullptr, const CDictionaryCodec * codec = nullptr);
+}
+}
+
+#endif
@@ -3,8 +3,7 @@
 #define CLOCALCONFIGFILE_H
 
 #include <sstream>
-#include "../helpers/json_nlohmann.hpp"
-using Json_de = nlohmann::json;
+#include "../helpers/json_de.hpp"
 
 namespace de
 {
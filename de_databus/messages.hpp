@@ -24,6 +24,16 @@
 #define JSON_INTERMODULE_VERSION                "v"
 #define JSON_INTERMODULE_TIMESTAMP_INSTANCE     "u"
 #define JSON_INTERMODULE_RESEND                 "z"
+#define JSON_INTERMODULE_WIRE_ENCODING          "w"
+#define JSON_INTERMODULE_DICTIONARY_ID          "x"
+#define JSON_INTERMODULE_PAYLOAD_COMPRESSION    "y"
+#define JSON_INTERMODULE_DELTA_ENCODING         "k"
+#define JSON_INTERMODULE_SESSION_ALIASES        "n"
+#define JSON_INTERMODULE_ROUTING_PREFIX         "r"
+#define JSON_INTERMODULE_BINARY_TELEMETRY       "p"
+// TYPE_AndruavModule_Subscription
+#define JSON_INTERMODULE_SUBSCRIBED             "i"
+#define JSON_INTERMODULE_UNSUBSCRIBED           "o"
 
 
 
@@ -80,6 +90,11 @@
 #define ANDRUAV_PROTOCOL_MESSAGE_PERMISSION     "p"
 #define INTERMODULE_ROUTING_TYPE                "ty"
 #define INTERMODULE_MODULE_KEY                  "GU"
+// sequence numbers of a delta encoded message. see CModule::setDeltaEncoding
+#define INTERMODULE_DELTA_HEADER                "dl"
+// session aliases of module key and target id assigned by the communicator. see CModule::setSessionAliases
+#define INTERMODULE_MODULE_KEY_ALIAS            "GA"
+#define INTERMODULE_TARGET_ID_ALIAS             "ta"
 #define WAITING_EVENT                           "ew"
 #define FIRE_EVENT                              "ef"
 #define LINKED_TO_STEP                          "ls"
@@ -102,6 +117,7 @@
 #define TYPE_AndruavModule_ID                   9100
 #define TYPE_AndruavModule_RemoteExecute        9101
 #define TYPE_AndruavModule_Location_Info        9102
+#define TYPE_AndruavModule_Subscription         9103
 
 
 
@@ -390,6 +406,7 @@
 #define TYPE_AndruavModule_ID                           9100
 #define TYPE_AndruavModule_RemoteExecute                9101
 #define TYPE_AndruavModule_Location_Info                9102
+#define TYPE_AndruavModule_Subscription                 9103
 
 
 // #define TYPE_AndruavMessage_Sonar_Info              13001
@@ -1,13 +1,13 @@
 #include <iostream>
 #include <cstring>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <unistd.h>
 
 #include "../helpers/colors.hpp"
-#include "../helpers/json_nlohmann.hpp"
-using Json_de = nlohmann::json;
+#include "../helpers/json_de.hpp"
 
 #include "udpClient.hpp"
 
@@ -188,7 +188,7 @@ void de::comm::CUDPClient::InternalReceiverEntry()
 
     struct sockaddr_in cliaddr;
     __socklen_t sender_address_size = sizeof(cliaddr);
-    std::vector<std::vector<uint8_t>> receivedChunks;
+    m_reassembly_buffer.reserve(DEFAULT_UDP_DATABUS_PACKET_SIZE);
 
 #ifndef DE_DISABLE_TRY
     try
@@ -216,33 +216,27 @@ void de::comm::CUDPClient::InternalReceiverEntry()
 
                 if (chunkNumber == 0)
                    // clear any corrupted/incomplete packets
-                   receivedChunks.clear();
+                   m_reassembly_buffer.clear();
 
-                // Store the received chunk in the map
-                receivedChunks.emplace_back(buffer + 2 * sizeof(uint8_t), buffer + n);
+                // Append the received chunk. Chunks arrive in order.
+                m_reassembly_buffer.insert(m_reassembly_buffer.end(), buffer + 2 * sizeof(uint8_t), buffer + n);
 
                 if (end)
                 {
-                    // Concatenate the chunks in order
-                    std::vector<uint8_t> concatenatedData;
-                    for (auto &chunk : receivedChunks)
-                    {
-                        concatenatedData.insert(concatenatedData.end(), chunk.begin(), chunk.end());
-                    }
                     // NOTICE WE DONT KNOW
                     // if this is a test message or text and binary
                     // so we inject null at the end
                     // it should be removed later if it is binary.
-                    concatenatedData.push_back(0);
+                    m_reassembly_buffer.push_back(0);
 
                     // Call the onReceive callback with the concatenated data
                     if (m_callback != nullptr)
                     {
-                        m_callback->onReceive((const char *)concatenatedData.data(), concatenatedData.size());
+                        m_callback->onReceive(m_reassembly_buffer.data(), m_reassembly_buffer.size());
                     }
 
-                    // Clear the map for the next set of chunks
-                    receivedChunks.clear();
+                    // Clear the buffer for the next set of chunks. Capacity is kept.
+                    m_reassembly_buffer.clear();
                 }
             }
             else
@@ -273,6 +267,7 @@ void de::comm::CUDPClient::InternalReceiverEntry()
  */
 void de::comm::CUDPClient::setJsonId(std::string jsonID)
 {
+    std::lock_guard<std::mutex> lock(m_lock2);
     m_JsonID = jsonID;
 }
 
@@ -287,10 +282,13 @@ void de::comm::CUDPClient::InternelSenderIDEntry()
 
     while (!m_stopped_called)
     {
-        std::lock_guard<std::mutex> lock(m_lock2);
-        if (!m_JsonID.empty())
         {
-            sendMSG(m_JsonID.c_str(), m_JsonID.length());
+            // ID can be replaced during the session. see CModule::setSessionAliases
+            std::lock_guard<std::mutex> lock(m_lock2);
+            if (!m_JsonID.empty())
+            {
+                sendMSG(m_JsonID.c_str(), m_JsonID.length());
+            }
         }
         std::this_thread::sleep_for(std::chrono::seconds(1)); 
     }
@@ -301,6 +299,15 @@ void de::comm::CUDPClient::InternelSenderIDEntry()
 }
 
 void de::comm::CUDPClient::sendMSG(const char *msg, const int length)
+{
+    sendMSG(nullptr, 0, msg, length);
+}
+
+/**
+ * @brief sends prefix followed by msg as one message.
+ * @details prefix is gathered into the first chunk so msg is not copied behind it.
+ */
+void de::comm::CUDPClient::sendMSG(const char *prefix, const int prefix_length, const char *msg, const int length)
 {
     if (m_chunkSize <= 0)
     {
@@ -314,7 +321,7 @@ void de::comm::CUDPClient::sendMSG(const char *msg, const int length)
     try
     {
 #endif
-        int remainingLength = length;
+        int remainingLength = prefix_length + length;
         int offset = 0;
         int chunk_number = 0;
 
@@ -323,31 +330,55 @@ void de::comm::CUDPClient::sendMSG(const char *msg, const int length)
             int chunkLength = std::min(m_chunkSize, remainingLength);
             remainingLength -= chunkLength;
 
-            // Create a new message with the chunk size + sizeof(uint8_t)
-            char chunkMsg[chunkLength + 2 * sizeof(uint8_t)];
+            // Chunk header is the chunk number
+            uint8_t chunkHeader[2];
 
-            // Set the first byte as chunk number
             if (remainingLength == 0)
             {
                 // IMPORTANT: Last packet is always equal to 255 (0xff) regardless if its actual number.
-                chunkMsg[0] = 0xFF;
-                chunkMsg[1] = 0xFF;
+                chunkHeader[0] = 0xFF;
+                chunkHeader[1] = 0xFF;
             }
             else
             {
-                chunkMsg[0] = static_cast<uint8_t>(chunk_number & 0xFF);
-                chunkMsg[1] = static_cast<uint8_t>((chunk_number >> 8) & 0xFF);
+                chunkHeader[0] = static_cast<uint8_t>(chunk_number & 0xFF);
+                chunkHeader[1] = static_cast<uint8_t>((chunk_number >> 8) & 0xFF);
             }
 
 #ifdef DDEBUG
             std::cout << "chunkNumber:" << chunk_number << " :chunkLength :" << chunkLength << std::endl;
 #endif
 
-            std::memcpy(chunkMsg + 2 * sizeof(uint8_t), msg + offset, chunkLength);
+            // header and payload are gathered by the kernel so the payload is not copied.
+            struct iovec chunkParts[3];
+            chunkParts[0].iov_base = chunkHeader;
+            chunkParts[0].iov_len = sizeof(chunkHeader);
+            int chunkPartCount = 1;
+
+            int prefixPartLength = 0;
+            if (offset < prefix_length)
+            {
+                prefixPartLength = std::min(prefix_length - offset, chunkLength);
+                chunkParts[chunkPartCount].iov_base = const_cast<char *>(prefix + offset);
+                chunkParts[chunkPartCount].iov_len = prefixPartLength;
+                ++chunkPartCount;
+            }
+
+            if (chunkLength > prefixPartLength)
+            {
+                chunkParts[chunkPartCount].iov_base = const_cast<char *>(msg + offset + prefixPartLength - prefix_length);
+                chunkParts[chunkPartCount].iov_len = chunkLength - prefixPartLength;
+                ++chunkPartCount;
+            }
+
+            struct msghdr chunkMsg;
+            std::memset(&chunkMsg, 0, sizeof(chunkMsg));
+            chunkMsg.msg_name = m_CommunicatorModuleAddress;
+            chunkMsg.msg_namelen = sizeof(struct sockaddr_in);
+            chunkMsg.msg_iov = chunkParts;
+            chunkMsg.msg_iovlen = chunkPartCount;
 
-            const int sent = sendto(m_SocketFD, chunkMsg, chunkLength + 2 * sizeof(uint8_t),
-                              MSG_CONFIRM, (const struct sockaddr *)m_CommunicatorModuleAddress,
-                              sizeof(struct sockaddr_in));
+            const int sent = sendmsg(m_SocketFD, &chunkMsg, MSG_CONFIRM);
 
             if (sent < 0)
             {
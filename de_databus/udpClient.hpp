@@ -4,6 +4,7 @@
 
 #include <thread>         // std::thread
 #include <mutex>          // std::mutex, std::unique_lock
+#include <vector>
 
 #ifndef MAXLINE
 #define MAXLINE 65507 
@@ -43,6 +44,7 @@ class CUDPClient
         void stop();
         void setJsonId (std::string jsonID);
         void sendMSG(const char * msg, const int length);
+        void sendMSG(const char * prefix, const int prefix_length, const char * msg, const int length);
 
         inline bool isStarted() const { return m_starrted;}
 
@@ -71,6 +73,12 @@ class CUDPClient
  
         char buffer[MAXLINE]; 
         int m_chunkSize;
+
+        /**
+         * @brief chunks of the message being received are appended here.
+         * @details keeps its capacity between messages so receiving does not allocate.
+         */
+        std::vector<char> m_reassembly_buffer;
         
 };
 }
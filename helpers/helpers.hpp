@@ -9,8 +9,7 @@
 #include <sstream>
 #include <math.h>
 
-#include "json_nlohmann.hpp"
-using Json_de = nlohmann::json;
+#include "json_de.hpp"
 
 std::string get_time_string();
 
@@ -0,0 +1,356 @@
+#ifndef JSON_DE_H_
+#define JSON_DE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <memory_resource>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+#include "json_nlohmann.hpp"
+
+
+// size of the arena buffer that is allocated once per thread.
+// messages whose DOM does not fit continue in blocks taken from the heap.
+#ifndef JSON_ARENA_INITIAL_SIZE
+#define JSON_ARENA_INITIAL_SIZE     (16 * 1024)
+#endif
+
+// entries reserved by CFlatJsonObject on first insert. protocol objects rarely have more.
+#ifndef JSON_FLAT_OBJECT_INITIAL_CAPACITY
+#define JSON_FLAT_OBJECT_INITIAL_CAPACITY     8
+#endif
+
+
+namespace de
+{
+    /**
+     * @brief memory resource used by CJsonArenaAllocator on the current thread.
+     * @details heap unless a CJsonArenaScope is active.
+     */
+    inline std::pmr::memory_resource *& currentJsonResource ()
+    {
+        static thread_local std::pmr::memory_resource * resource = std::pmr::new_delete_resource();
+
+        return resource;
+    }
+
+
+    /**
+     * @brief allocator of Json_de_arena nodes.
+     * @details nlohmann default constructs a new allocator for every node it creates
+     * or destroys, so the allocator can not carry its resource. Instead each block
+     * records the resource it came from in a small header, and the resource is
+     * chosen at allocation time from currentJsonResource().
+     * Nodes allocated outside an arena scope therefore live on the heap and
+     * are freed normally wherever they are destroyed.
+     */
+    template <typename T>
+    class CJsonArenaAllocator
+    {
+        public:
+
+            typedef T value_type;
+            typedef std::true_type is_always_equal;
+
+            CJsonArenaAllocator () noexcept = default;
+
+            template <typename U>
+            CJsonArenaAllocator (const CJsonArenaAllocator<U>&) noexcept {}
+
+            T * allocate (const std::size_t n)
+            {
+                std::pmr::memory_resource * resource = currentJsonResource();
+                char * block = static_cast<char *>(resource->allocate(HEADER_SIZE + n * sizeof(T), ALIGNMENT));
+                *reinterpret_cast<std::pmr::memory_resource **>(block) = resource;
+                return reinterpret_cast<T *>(block + HEADER_SIZE);
+            }
+
+            void deallocate (T * p, const std::size_t n) noexcept
+            {
+                char * block = reinterpret_cast<char *>(p) - HEADER_SIZE;
+                std::pmr::memory_resource * resource = *reinterpret_cast<std::pmr::memory_resource **>(block);
+                resource->deallocate(block, HEADER_SIZE + n * sizeof(T), ALIGNMENT);
+            }
+
+            template <typename U>
+            bool operator== (const CJsonArenaAllocator<U>&) const noexcept { return true; }
+
+            template <typename U>
+            bool operator!= (const CJsonArenaAllocator<U>&) const noexcept { return false; }
+
+        private:
+
+            static constexpr std::size_t ALIGNMENT = (alignof(T) > alignof(std::max_align_t)) ? alignof(T) : alignof(std::max_align_t);
+            static constexpr std::size_t HEADER_SIZE = ALIGNMENT;
+    };
+
+
+    /**
+     * @brief per thread monotonic arena for DOMs of received messages.
+     * @details nested users are counted. Memory is released in one step when
+     * the outermost user leaves, so all DOMs built in the arena must be destroyed by then.
+     */
+    class CJsonArena
+    {
+        public:
+
+            static CJsonArena& getThreadInstance ()
+            {
+                static thread_local CJsonArena instance;
+
+                return instance;
+            }
+
+            CJsonArena(CJsonArena const&)         = delete;
+            void operator=(CJsonArena const&)     = delete;
+
+        private:
+
+            CJsonArena () : m_resource(m_buffer, sizeof(m_buffer), std::pmr::new_delete_resource()) {}
+
+        public:
+
+            inline std::pmr::memory_resource * getResource () { return &m_resource; }
+
+            inline void enter () { ++m_users; }
+
+            inline void leave ()
+            {
+                if (--m_users == 0) m_resource.release();
+            }
+
+        private:
+
+            alignas(std::max_align_t) char m_buffer[JSON_ARENA_INITIAL_SIZE];
+            std::pmr::monotonic_buffer_resource m_resource;
+            int m_users = 0;
+    };
+
+
+    /**
+     * @brief makes Json_de_arena nodes allocated in this scope come from resource.
+     * @param resource nullptr keeps the current resource.
+     */
+    class CJsonArenaScope
+    {
+        public:
+
+            explicit CJsonArenaScope (std::pmr::memory_resource * resource)
+                : m_previous(currentJsonResource())
+            {
+                if (resource != nullptr) currentJsonResource() = resource;
+            }
+
+            ~CJsonArenaScope ()
+            {
+                currentJsonResource() = m_previous;
+            }
+
+            CJsonArenaScope(CJsonArenaScope const&)       = delete;
+            void operator=(CJsonArenaScope const&)        = delete;
+
+        private:
+
+            std::pmr::memory_resource * m_previous;
+    };
+
+
+    /**
+     * @brief contiguous object storage for protocol messages.
+     * @details protocol objects have a handful of 1-2 character keys. Entries are kept
+     * in one vector in insertion order, so an object is one allocation instead of one
+     * node per key, and lookup is a linear scan over adjacent entries.
+     * Short keys are stored inline by std::string small string optimization.
+     * Lookup is O(n) so it is not meant for large objects such as config files.
+     * Interface follows nlohmann::ordered_map, which is what basic_json expects.
+     */
+    template <class Key, class T, class IgnoredLess = std::less<Key>,
+              class Allocator = std::allocator<std::pair<const Key, T>>>
+    class CFlatJsonObject : public std::vector<std::pair<const Key, T>, Allocator>
+    {
+        public:
+
+            using key_type = Key;
+            using mapped_type = T;
+            using Container = std::vector<std::pair<const Key, T>, Allocator>;
+            using typename Container::iterator;
+            using typename Container::const_iterator;
+            using typename Container::size_type;
+            using typename Container::value_type;
+
+            CFlatJsonObject (const Allocator& alloc = Allocator()) : Container{alloc} {}
+
+            template <class It>
+            CFlatJsonObject (It first, It last, const Allocator& alloc = Allocator())
+                : Container{alloc}
+            {
+                insert(first, last);
+            }
+
+            CFlatJsonObject (std::initializer_list<value_type> init, const Allocator& alloc = Allocator())
+                : Container{alloc}
+            {
+                insert(init.begin(), init.end());
+            }
+
+        public:
+
+            iterator find (const Key& key)
+            {
+                const iterator last = this->end();
+                for (iterator it = this->begin(); it != last; ++it)
+                {
+                    if (isSameKey(it->first, key)) return it;
+                }
+                return last;
+            }
+
+            const_iterator find (const Key& key) const
+            {
+                const const_iterator last = this->end();
+                for (const_iterator it = this->begin(); it != last; ++it)
+                {
+                    if (isSameKey(it->first, key)) return it;
+                }
+                return last;
+            }
+
+            size_type count (const Key& key) const
+            {
+                return (find(key) == this->end()) ? 0 : 1;
+            }
+
+            std::pair<iterator, bool> emplace (const key_type& key, T&& t)
+            {
+                const iterator it = find(key);
+                if (it != this->end()) return {it, false};
+
+                if (this->capacity() == 0) this->reserve(JSON_FLAT_OBJECT_INITIAL_CAPACITY);
+                Container::emplace_back(key, std::move(t));
+                return {std::prev(this->end()), true};
+            }
+
+            T& operator[] (const Key& key)
+            {
+                return emplace(key, T{}).first->second;
+            }
+
+            const T& operator[] (const Key& key) const
+            {
+                return at(key);
+            }
+
+            T& at (const Key& key)
+            {
+                const iterator it = find(key);
+                if (it == this->end()) throw std::out_of_range("key not found");
+                return it->second;
+            }
+
+            const T& at (const Key& key) const
+            {
+                const const_iterator it = find(key);
+                if (it == this->end()) throw std::out_of_range("key not found");
+                return it->second;
+            }
+
+            size_type erase (const Key& key)
+            {
+                const iterator it = find(key);
+                if (it == this->end()) return 0;
+
+                erase(it);
+                return 1;
+            }
+
+            iterator erase (iterator pos)
+            {
+                // keys are const so entries are re-constructed in place instead of assigned.
+                iterator it = pos;
+                for (iterator next = it; ++next != this->end(); ++it)
+                {
+                    it->~value_type();
+                    new (&*it) value_type{std::move(*next)};
+                }
+                Container::pop_back();
+                return pos;
+            }
+
+            std::pair<iterator, bool> insert (value_type&& value)
+            {
+                return emplace(value.first, std::move(value.second));
+            }
+
+            std::pair<iterator, bool> insert (const value_type& value)
+            {
+                return emplace(value.first, T(value.second));
+            }
+
+            template <typename InputIt,
+                      typename = typename std::enable_if<std::is_convertible<typename std::iterator_traits<InputIt>::iterator_category,
+                                                                             std::input_iterator_tag>::value>::type>
+            void insert (InputIt first, InputIt last)
+            {
+                for (InputIt it = first; it != last; ++it)
+                {
+                    insert(*it);
+                }
+            }
+
+        private:
+
+            // most keys differ in length or first character so memcmp is rarely reached.
+            static inline bool isSameKey (const Key& a, const Key& b)
+            {
+                return (a.size() == b.size()) && ((a.size() == 0) || (a[0] == b[0])) && (a == b);
+            }
+    };
+}
+
+
+/**
+ * @brief nlohmann json whose object, array and string nodes are allocated by CJsonArenaAllocator.
+ * @details keys and string values remain std::string so the type converts
+ * to and from standard strings like nlohmann::json.
+ */
+using Json_de_arena = nlohmann::basic_json<std::map, std::vector, std::string, bool,
+                                           std::int64_t, std::uint64_t, double,
+                                           de::CJsonArenaAllocator>;
+
+
+/**
+ * @brief nlohmann json whose objects are CFlatJsonObject.
+ */
+using Json_de_flat = nlohmann::basic_json<de::CFlatJsonObject>;
+
+
+/**
+ * @brief JSON type used across databus.
+ * @details build options:
+ *  DE_JSON_ARENA: allow received message DOMs to be allocated from a per thread arena. see CModule::setInboundArena
+ *  DE_JSON_FLAT_OBJECT: store objects in CFlatJsonObject. Objects keep insertion order
+ *                       instead of being sorted by key.
+ * With neither option Json_de is nlohmann::json.
+ */
+#ifdef DE_JSON_FLAT_OBJECT
+#define DE_JSON_OBJECT_TYPE         de::CFlatJsonObject
+#else
+#define DE_JSON_OBJECT_TYPE         std::map
+#endif
+
+#ifdef DE_JSON_ARENA
+#define DE_JSON_ALLOCATOR_TYPE      de::CJsonArenaAllocator
+#else
+#define DE_JSON_ALLOCATOR_TYPE      std::allocator
+#endif
+
+using Json_de = nlohmann::basic_json<DE_JSON_OBJECT_TYPE, std::vector, std::string, bool,
+                                     std::int64_t, std::uint64_t, double,
+                                     DE_JSON_ALLOCATOR_TYPE>;
+
+#endif
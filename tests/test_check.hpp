@@ -0,0 +1,27 @@
+#ifndef DE_TEST_CHECK_H_
+#define DE_TEST_CHECK_H_
+
+#include <iostream>
+
+/**
+ * @brief minimal checks for the standalone test programs in this folder.
+ * @details a failed check is reported and counted, and the program exits with 1.
+ */
+inline int& testFailures ()
+{
+    static int failures = 0;
+    return failures;
+}
+
+
+#define CHECK(condition) \
+    do { if (!(condition)) { ++testFailures(); std::cout << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; } } while (0)
+
+
+inline int testResult (const char * test_name)
+{
+    std::cout << test_name << ((testFailures() == 0) ? ": passed" : ": FAILED") << std::endl;
+    return (testFailures() == 0) ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,83 @@
+// Inbound mailbox overflow: only state messages are dropped, commands are always delivered. See README.md.
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "test_check.hpp"
+#include "../de_databus/messages.hpp"
+#include "../de_databus/de_module.hpp"
+
+using namespace de::comm;
+
+
+#define MAILBOX_MAX_MESSAGES        16
+#define FLOOD_SENDERS               200
+
+
+static std::atomic<bool> release_handler{false};
+static std::atomic<int> states_delivered{0};
+static std::atomic<int> commands_delivered{0};
+
+
+static void receive (CModule& module, const std::string& sender, const int message_type)
+{
+    // as received from CUDPClient: 0 appended after reassembly.
+    std::string message = "{\"" ANDRUAV_PROTOCOL_SENDER "\":\"" + sender + "\",\"" ANDRUAV_PROTOCOL_MESSAGE_TYPE "\":"
+                        + std::to_string(message_type) + ",\"" INTERMODULE_ROUTING_TYPE "\":\"" CMD_COMM_INDIVIDUAL "\",\""
+                        ANDRUAV_PROTOCOL_MESSAGE_CMD "\":{}}";
+    message += '\0';
+    module.onReceive(message.data(), static_cast<int>(message.length()));
+}
+
+
+int main ()
+{
+    CModule& module = CModule::getInstance();
+
+    module.setMessageHandler(TYPE_AndruavMessage_POWER, [](const CInboundMessage&)
+    {
+        // blocks the mailbox thread so the receive side fills the mailbox.
+        while (!release_handler) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++states_delivered;
+    });
+    module.setMessageHandler(TYPE_AndruavMessage_Arm, [](const CInboundMessage&) { ++commands_delivered; });
+
+    module.setInboundMailbox(true, MAILBOX_MAX_MESSAGES);
+
+    // first state message is taken by the mailbox thread, which then waits in the handler.
+    receive(module, "sender_0", TYPE_AndruavMessage_POWER);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // a command early in a flood of state messages from distinct senders, so none is superseded.
+    receive(module, "sender_1", TYPE_AndruavMessage_POWER);
+    receive(module, "gcs", TYPE_AndruavMessage_Arm);
+    for (int i = 2; i < FLOOD_SENDERS; ++i)
+    {
+        receive(module, "sender_" + std::to_string(i), TYPE_AndruavMessage_POWER);
+    }
+
+    std::map<int, INBOUND_MESSAGE_COUNTERS> counters = module.getInboundMailboxCounters();
+    CHECK(counters[TYPE_AndruavMessage_Arm].dropped == 0);
+    CHECK(counters[TYPE_AndruavMessage_POWER].dropped == FLOOD_SENDERS - 1 - (MAILBOX_MAX_MESSAGES - 1));
+
+    // commands push out the waiting state messages, then the mailbox grows beyond its limit
+    // instead of dropping commands.
+    for (int i = 0; i < MAILBOX_MAX_MESSAGES * 2; ++i)
+    {
+        receive(module, "gcs", TYPE_AndruavMessage_Arm);
+    }
+    counters = module.getInboundMailboxCounters();
+    CHECK(counters[TYPE_AndruavMessage_Arm].dropped == 0);
+    CHECK(counters[TYPE_AndruavMessage_POWER].dropped == FLOOD_SENDERS - 1);
+
+    release_handler = true;
+    // disabling delivers the remaining messages.
+    module.setInboundMailbox(false);
+
+    CHECK(commands_delivered == 1 + MAILBOX_MAX_MESSAGES * 2);
+    CHECK(states_delivered == 1);
+
+    return testResult("test_inbound_mailbox");
+}
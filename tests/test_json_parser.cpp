@@ -0,0 +1,168 @@
+// Compares JSON_PARSER_STRUCTURAL with Json_de::parse on the corpus in data/json_parser and on
+// mutations of it. See README.md.
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "test_check.hpp"
+#include "../de_databus/de_json_parser.hpp"
+
+using namespace de::comm;
+
+
+// mutations per corpus file.
+#define MUTATIONS_PER_DOCUMENT      300
+
+// tests/CMakeLists.txt defines the corpus folder. Otherwise it is found next to this file,
+// which works when the compiler is given this file's absolute path or runs from the repository root.
+#ifndef TEST_JSON_PARSER_CORPUS_DIR
+#define TEST_JSON_PARSER_CORPUS_DIR     (std::filesystem::path(__FILE__).parent_path() / "data" / "json_parser").string()
+#endif
+
+
+typedef struct
+{
+    bool thrown;
+    int id;
+    std::string text;
+} PARSE_RESULT;
+
+
+/**
+ * @brief dump() of the value or id and message of the exception.
+ * @details dump() tells apart number types (1, 1.0, -0.0) that operator== treats as equal.
+ */
+static PARSE_RESULT parseWith (const std::string& text, const ENUM_JSON_PARSER parser)
+{
+    PARSE_RESULT result {false, 0, std::string()};
+    try
+    {
+        result.text = parseJson(text.data(), text.data() + text.size(), parser).dump();
+    }
+    catch (const Json_de::exception& e)
+    {
+        result.thrown = true;
+        result.id = e.id;
+        result.text = e.what();
+    }
+    return result;
+}
+
+
+static bool sameResult (const std::string& text, const std::string& name)
+{
+    const PARSE_RESULT expected = parseWith(text, JSON_PARSER_NLOHMANN);
+    const PARSE_RESULT actual = parseWith(text, JSON_PARSER_STRUCTURAL);
+
+    const bool same = (expected.thrown == actual.thrown) && (expected.id == actual.id) && (expected.text == actual.text);
+    if (!same)
+    {
+        std::cout << name << ": nlohmann " << (expected.thrown ? "threw " : "returned ") << expected.text.substr(0, 200)
+                  << " structural " << (actual.thrown ? "threw " : "returned ") << actual.text.substr(0, 200) << std::endl;
+    }
+    return same;
+}
+
+
+static std::string readFile (const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+
+/**
+ * @brief deterministic mutation: byte flip, structural or escape insertion, deletion or truncation.
+ */
+static std::string mutate (const std::string& text, uint64_t& seed)
+{
+    static const char * const tokens[] = {"{", "}", "[", "]", ":", ",", "\"", "\\", "\\u", "\\ud83d", "0", "-", ".", "e", "1e999", "\x80", "\xC3\xA9", " ", "\x00"};
+    auto next = [&seed]() { seed = seed * 6364136223846793005ULL + 1442695040888963407ULL; return seed >> 33; };
+
+    std::string mutated = text;
+    if (mutated.empty()) return std::string(tokens[next() % 18]);
+
+    const std::size_t position = next() % mutated.size();
+    switch (next() % 4)
+    {
+        case 0:
+            mutated[position] = static_cast<char>(next() & 0xFF);
+            break;
+        case 1:
+        {
+            const char * token = tokens[next() % (sizeof(tokens) / sizeof(tokens[0]))];
+            mutated.insert(position, token, std::max<std::size_t>(std::char_traits<char>::length(token), 1));
+            break;
+        }
+        case 2:
+            mutated.erase(position, 1 + next() % 8);
+            break;
+        default:
+            mutated.resize(position);
+            break;
+    }
+    return mutated;
+}
+
+
+int main (int argc, char * argv[])
+{
+    const std::filesystem::path corpus = (argc > 1) ? std::filesystem::path(argv[1]) : std::filesystem::path(TEST_JSON_PARSER_CORPUS_DIR);
+
+    std::error_code error;
+    if (!std::filesystem::is_directory(corpus, error))
+    {
+        std::cout << "corpus folder " << corpus << " not found. Pass the path of tests/data/json_parser as argument" << std::endl;
+        CHECK(std::filesystem::is_directory(corpus, error));
+        return testResult("test_json_parser");
+    }
+
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator(corpus))
+    {
+        if (entry.path().extension() == ".json") files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    CHECK(!files.empty());
+
+    uint64_t seed = 1;
+    std::size_t documents = 0;
+    for (const std::filesystem::path& path : files)
+    {
+        const std::string text = readFile(path);
+        const std::string name = path.filename().string();
+
+        // valid_ files parse, invalid_ files throw.
+        const PARSE_RESULT expected = parseWith(text, JSON_PARSER_NLOHMANN);
+        CHECK(expected.thrown == (name.rfind("invalid_", 0) == 0));
+
+        CHECK(sameResult(text, name));
+        ++documents;
+
+        for (int i = 0; i < MUTATIONS_PER_DOCUMENT; ++i)
+        {
+            CHECK(sameResult(mutate(text, seed), name + " mutation " + std::to_string(i)));
+            ++documents;
+        }
+    }
+
+    // quotes and backslash runs at every offset of a 64 byte block.
+    for (std::size_t offset = 0; offset < 130; ++offset)
+    {
+        for (std::size_t backslashes = 0; backslashes < 4; ++backslashes)
+        {
+            const std::string text = "[\"" + std::string(offset, 'a') + std::string(backslashes, '\\') + "\"]";
+            CHECK(sameResult(text, "offset " + std::to_string(offset) + " backslashes " + std::to_string(backslashes)));
+            ++documents;
+        }
+    }
+
+    std::cout << documents << " documents, " << getJsonParserFallbackCount() << " handed to nlohmann, "
+              << CJsonStructuralIndex::getImplementationName() << std::endl;
+    return testResult("test_json_parser");
+}
@@ -0,0 +1,111 @@
+/**
+ * @brief checks message type lookup and filtering of CMessagePrefilter. see README.md
+ */
+#include <iostream>
+#include <string>
+
+#include "../de_databus/messages.hpp"
+#include "../de_databus/de_routing_prefix.hpp"
+#include "../de_databus/de_message_prefilter.hpp"
+
+#include "test_check.hpp"
+
+using namespace de::comm;
+
+
+// as received from CUDPClient: 0 appended after reassembly.
+static std::string received (const std::string& message)
+{
+    return message + '\0';
+}
+
+
+static bool peek (const std::string& message, int& message_type)
+{
+    message_type = -1;
+    return peekMessageType(message.data(), message.length(), message_type);
+}
+
+
+int main ()
+{
+    int message_type;
+
+    // Json_de::dump() sorts keys so "ms" comes before "mt".
+    Json_de envelope;
+    envelope[INTERMODULE_MODULE_KEY] = "KEY1";
+    envelope[INTERMODULE_ROUTING_TYPE] = CMD_COMM_INDIVIDUAL;
+    envelope[ANDRUAV_PROTOCOL_TARGET_ID] = "P1";
+    envelope[ANDRUAV_PROTOCOL_MESSAGE_TYPE] = TYPE_AndruavMessage_GPS;
+    envelope[ANDRUAV_PROTOCOL_MESSAGE_CMD] = {{"mt", 1}, {"la", 30.5}, {"ms", {{"mt", 2}}}};
+    const std::string dumped = envelope.dump();
+    CHECK(dumped.find("\"ms\"") < dumped.find("\"mt\":" + std::to_string(TYPE_AndruavMessage_GPS)));
+    CHECK(peek(received(dumped), message_type) && (message_type == TYPE_AndruavMessage_GPS));
+
+    // indented text and any key order.
+    CHECK(peek(received(envelope.dump(4)), message_type) && (message_type == TYPE_AndruavMessage_GPS));
+    CHECK(peek(received(R"({ "ty" : "g", "tg" : "mt", "mt" : 1003 , "ms" : {} })"), message_type) && (message_type == 1003));
+
+    // binary part is not scanned even if it looks like JSON.
+    std::string binary = received(R"({"ms":{},"ty":"g"})") + R"(,"mt":1040})";
+    binary += '\0';
+    CHECK(!peek(binary, message_type));
+    binary = received(R"({"ms":{},"mt":1036,"ty":"g"})") + std::string("\x01\x00\x02", 3) + '\0';
+    CHECK(peek(binary, message_type) && (message_type == 1036));
+
+    // routing prefix is read without scanning.
+    ROUTING_PREFIX routing_prefix;
+    CHECK(makeRoutingPrefix(1036, CMD_COMM_GROUP, false, 0, routing_prefix));
+    char prefix[ROUTING_PREFIX_SIZE];
+    writeRoutingPrefix(routing_prefix, prefix);
+    CHECK(peek(std::string(prefix, ROUTING_PREFIX_SIZE) + received(R"({"mt":1,"ms":{}})"), message_type) && (message_type == 1036));
+
+    // not found: encoded frames, no type, malformed text.
+    CHECK(!peek(std::string("\xDE\x01\x00\x00", 4), message_type));
+    CHECK(!peek(received(R"({"ms":{"mt":1002},"ty":"g"})"), message_type));
+    CHECK(!peek(received(R"({"ms":{"a":1,"mt":1002})"), message_type));
+    CHECK(!peek(std::string(), message_type));
+
+    // integral reals are types, other numbers are not: no out of range or fractional cast.
+    CHECK(peek(received(R"({"mt":1.002e3,"ms":{}})"), message_type) && (message_type == 1002));
+    CHECK(peek(received(R"({"mt":-2147483648.0,"ms":{}})"), message_type) && (message_type == -2147483647 - 1));
+    CHECK(!peek(received(R"({"mt":1002.5,"ms":{}})"), message_type));
+    CHECK(!peek(received(R"({"mt":2147483648,"ms":{}})"), message_type));
+    CHECK(!peek(received(R"({"mt":1e300,"ms":{}})"), message_type));
+    CHECK(!peek(received(R"({"mt":1e999,"ms":{}})"), message_type));
+    CHECK(!peek(received(R"({"mt":-inf,"ms":{}})"), message_type));
+    CHECK(!peek(received(R"({"mt":0x3ea,"ms":{}})"), message_type));
+
+    // filtering and counters.
+    CMessagePrefilter prefilter;
+    prefilter.setMessageTypes(Json_de::array({TYPE_AndruavMessage_GPS, 80001}));
+    const std::string gps = received(dumped);
+    envelope[ANDRUAV_PROTOCOL_MESSAGE_TYPE] = TYPE_AndruavMessage_POWER;
+    const std::string power = received(envelope.dump());
+    envelope[ANDRUAV_PROTOCOL_MESSAGE_TYPE] = TYPE_AndruavModule_ID;
+    const std::string module_id = received(envelope.dump());
+    const std::string unknown = received(R"({"ms":{"mt":1002}})");
+
+    // disabled prefilter passes everything and counts nothing.
+    CHECK(prefilter.accept(power.data(), power.length()));
+    CHECK(prefilter.getCounters().empty());
+
+    prefilter.setEnabled(true);
+    CHECK(prefilter.accept(gps.data(), gps.length()));
+    CHECK(!prefilter.accept(power.data(), power.length()));
+    CHECK(!prefilter.accept(power.data(), power.length()));
+    CHECK(prefilter.accept(module_id.data(), module_id.length()));
+    CHECK(prefilter.accept(unknown.data(), unknown.length()));
+
+    const std::map<int, MESSAGE_PREFILTER_COUNTERS> counters = prefilter.getCounters();
+    CHECK(counters.size() == 3);
+    CHECK((counters.at(TYPE_AndruavMessage_GPS).passed == 1) && (counters.at(TYPE_AndruavMessage_GPS).filtered == 0));
+    CHECK((counters.at(TYPE_AndruavMessage_POWER).passed == 0) && (counters.at(TYPE_AndruavMessage_POWER).filtered == 2));
+    CHECK(counters.at(TYPE_AndruavModule_ID).passed == 1);
+
+    prefilter.setMessageTypes(Json_de::array({TYPE_AndruavMessage_POWER}));
+    CHECK(!prefilter.accept(gps.data(), gps.length()));
+    CHECK(prefilter.accept(power.data(), power.length()));
+
+    return testResult("test_message_prefilter");
+}
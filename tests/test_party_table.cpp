@@ -0,0 +1,66 @@
+// CPartyTable interning, eviction of least recently used parties and handle reuse. See README.md.
+
+#include <set>
+#include <string>
+
+#include "test_check.hpp"
+#include "../de_databus/de_party_table.hpp"
+
+using namespace de::comm;
+
+
+int main ()
+{
+    CPartyTable table;
+    CHECK(table.intern("") == 0);
+
+    const PARTY_HANDLE first = table.intern("party_0");
+    CHECK(table.intern("party_0") == first);
+    CHECK(table.getPartyId(first) == "party_0");
+
+    // frequent party gets an alias.
+    for (int i = 0; i < 3; ++i) table.countUse(first, 3);
+    Json_de aliases;
+    aliases["party_0"] = 7u;
+    CHECK(table.setAliases(aliases));
+    CHECK(table.getAlias(first) == 7);
+
+    for (int i = 1; !table.isFull(); ++i) table.intern("party_" + std::to_string(i));
+
+    // party_1 is among the least recently used parties but still held by a stream.
+    const PARTY_HANDLE held = table.intern("party_1");
+    // party_2 becomes the most recently used one.
+    const PARTY_HANDLE recent = table.intern("party_2");
+    for (int i = 3; i < 1000; ++i) table.intern("party_" + std::to_string(i));
+    table.intern("party_2");
+
+    const std::vector<PARTY_HANDLE> evicted = table.evict(std::set<PARTY_HANDLE>{held});
+    CHECK(evicted.size() == PARTY_TABLE_MAX_PARTIES / 4);
+    CHECK(!table.isFull());
+
+    const std::set<PARTY_HANDLE> evicted_set(evicted.begin(), evicted.end());
+    CHECK(evicted_set.count(0) == 0);
+    CHECK(evicted_set.count(first) == 0);
+    CHECK(evicted_set.count(held) == 0);
+    CHECK(evicted_set.count(recent) == 0);
+
+    // kept parties keep their handles, ids and aliases.
+    CHECK(table.intern("party_0") == first);
+    CHECK(table.getAlias(first) == 7);
+    CHECK(table.intern("party_1") == held);
+    CHECK(table.getPartyId(held) == "party_1");
+    CHECK(table.intern("party_2") == recent);
+
+    // evicted handles are reused for new parties.
+    const PARTY_HANDLE reused = table.intern("new_party");
+    CHECK(evicted_set.count(reused) == 1);
+    CHECK(table.getPartyId(reused) == "new_party");
+    CHECK(table.getAlias(reused) == 0);
+    CHECK(table.intern("new_party") == reused);
+
+    // the oldest unreferenced party was evicted and is interned again as a new party.
+    CHECK(table.intern("party_3") != held);
+    CHECK(table.getPartyId(table.intern("party_3")) == "party_3");
+
+    return testResult("test_party_table");
+}
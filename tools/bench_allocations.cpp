@@ -0,0 +1,112 @@
+// Heap allocations per sendJMSG / sendBMSG with the former by-value signatures and with the string_view
+// and const& ones, and per received message for each setMessageOnReceive callback form. See README.md.
+
+#define DE_MODULE_BUILD_REMOVED_API
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "count_allocations.hpp"
+#include "../de_databus/messages.hpp"
+#include "../de_databus/de_module.hpp"
+
+using namespace de::comm;
+
+
+#define BENCH_MESSAGES      1000
+
+
+template <typename F>
+static double countAllocations (F&& step)
+{
+    step();     // warms buffer pools and party table.
+    const uint64_t start = allocations;
+    for (int i = 0; i < BENCH_MESSAGES; ++i) step();
+    return static_cast<double>(allocations - start) / BENCH_MESSAGES;
+}
+
+
+static Json_de makeGps ()
+{
+    return {{"3D", 3}, {"SC", 14}, {"p", 1}, {"la", 30.0444196}, {"ln", 31.2357116}, {"a", 152.4}, {"r", 50.25}, {"y", 1200}};
+}
+
+
+static Json_de makeMission ()
+{
+    Json_de mission = {{"n", 20}, {"W", Json_de::array()}};
+    for (int i = 0; i < 20; ++i)
+    {
+        mission["W"].push_back({{"seq", i}, {"t", 16}, {"la", 30.0444196 + i * 1e-4}, {"ln", 31.2357116 - i * 1e-4}, {"a", 50 + i}});
+    }
+    return mission;
+}
+
+
+static std::string makeReceived (const int message_type, const Json_de& message_cmd)
+{
+    Json_de message;
+    message[ANDRUAV_PROTOCOL_SENDER] = "party_0123456789abcdef";
+    message[ANDRUAV_PROTOCOL_MESSAGE_TYPE] = message_type;
+    message[INTERMODULE_ROUTING_TYPE] = CMD_COMM_INDIVIDUAL;
+    message[ANDRUAV_PROTOCOL_MESSAGE_CMD] = message_cmd;
+    // as received from CUDPClient: 0 appended after reassembly.
+    std::string text = message.dump();
+    text += '\0';
+    return text;
+}
+
+
+static void onReceiveValue (const char *, int, Json_de message) { if (message.is_null()) std::abort(); }
+static void onReceiveRef (const char *, int, const Json_de& message) { if (message.is_null()) std::abort(); }
+static void onReceiveMove (const char *, int, Json_de&& message) { if (message.is_null()) std::abort(); }
+static void onReceiveMessage (const CInboundMessage& message) { if (message.getCmd().is_null()) std::abort(); }
+
+
+static void report (const char * name, const int message_type, const Json_de& message_cmd)
+{
+    CModule& module = CModule::getInstance();
+    const std::string target = "party_0123456789abcdef";
+    const char payload[64] = {};
+
+    const double send_old = countAllocations([&]() { module.sendJMSG(target, message_cmd, message_type, false); });
+    const double send_new = countAllocations([&]() { module.sendJMSG(std::string_view(target), message_cmd, message_type, false); });
+    const double binary_old = countAllocations([&]() { module.sendBMSG(target, payload, sizeof(payload), message_type, false, message_cmd); });
+    const double binary_new = countAllocations([&]() { module.sendBMSG(std::string_view(target), payload, sizeof(payload), message_type, false, message_cmd); });
+
+    const std::string received = makeReceived(message_type, message_cmd);
+    auto receive = [&]() { module.onReceive(received.data(), static_cast<int>(received.length())); };
+
+    module.setMessageOnReceive(onReceiveValue);
+    const double receive_value = countAllocations(receive);
+    module.setMessageOnReceive(onReceiveRef);
+    const double receive_ref = countAllocations(receive);
+    module.setMessageOnReceive(onReceiveMove);
+    const double receive_move = countAllocations(receive);
+    module.setMessageOnReceive(onReceiveMessage);
+    const double receive_message = countAllocations(receive);
+
+    // what handing a by-value callback a copy of the DOM used to add on top.
+    const Json_de dom = Json_de::parse(received.c_str());
+    const double dom_copy = countAllocations([&]() { Json_de copy = dom; if (copy.is_null()) std::abort(); });
+
+    std::printf("%-8s %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n", name, send_old, send_new, binary_old, binary_new,
+                receive_value, receive_ref, receive_move, receive_message, dom_copy);
+}
+
+
+int main ()
+{
+    // not initialized: messages are serialized but not handed to the socket.
+    CModule::getInstance().defineModule("bench", "bench_module", "bench_key_0123456789", "1.0", Json_de::array());
+
+    std::printf("heap allocations per message, %d messages\n", BENCH_MESSAGES);
+    std::printf("%-8s %17s %17s %35s %8s\n", "", "sendJMSG", "sendBMSG", "receive callback", "");
+    std::printf("%-8s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n", "message", "by value", "view", "by value", "view",
+                "value", "const&", "&&", "inbound", "DOM copy");
+
+    report("GPS", TYPE_AndruavMessage_GPS, makeGps());
+    report("mission", TYPE_AndruavMessage_UploadWayPoints, makeMission());
+    return 0;
+}
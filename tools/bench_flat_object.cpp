@@ -0,0 +1,196 @@
+// Construction and key lookup of Json_de_flat (CFlatJsonObject) against nlohmann::json (std::map),
+// on captured databus messages per message type and on generated objects of 2 to 64 short keys.
+// See README.md.
+//
+// bench_flat_object [capture.jsonl]
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "count_allocations.hpp"
+#include "captured_traffic.hpp"
+
+using namespace de::comm;
+
+
+// each measurement runs over its messages or objects this many times.
+#define BENCH_PASSES        200
+
+
+typedef enum
+{
+    OBJECT_MAP      = 0,
+    OBJECT_FLAT     = 1,
+    OBJECT_COUNT    = 2
+} ENUM_BENCH_OBJECT;
+
+
+typedef struct
+{
+    std::size_t count;
+    std::size_t lookups;
+    double parse_ns[OBJECT_COUNT];
+    double build_ns[OBJECT_COUNT];
+    double lookup_ns[OBJECT_COUNT];
+    uint64_t parse_allocations[OBJECT_COUNT];
+} FLAT_TOTALS;
+
+
+/**
+ * @brief parses the messages, then copies the fields of each ms into a new object key by key
+ * as toJson() of the typed messages builds them, then looks every key of ms up.
+ */
+template <typename JSON>
+static void measure (const std::vector<std::string>& messages, const ENUM_BENCH_OBJECT object, FLAT_TOTALS& totals)
+{
+    std::vector<JSON> parsed(messages.size());
+    std::vector<std::vector<std::string>> keys(messages.size());
+    for (std::size_t i = 0; i < messages.size(); ++i)
+    {
+        parsed[i] = JSON::parse(messages[i]);
+        for (const auto& field : parsed[i][ANDRUAV_PROTOCOL_MESSAGE_CMD].items()) keys[i].push_back(field.key());
+    }
+
+    std::size_t sink = 0;
+    const uint64_t start_allocations = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < BENCH_PASSES; ++pass)
+    {
+        for (const std::string& message : messages)
+        {
+            const JSON json = JSON::parse(message);
+            sink += json.size();
+        }
+    }
+    totals.parse_ns[object] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_PASSES;
+    totals.parse_allocations[object] = (allocations - start_allocations) / BENCH_PASSES;
+
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < BENCH_PASSES; ++pass)
+    {
+        for (std::size_t i = 0; i < parsed.size(); ++i)
+        {
+            const JSON& message_cmd = parsed[i][ANDRUAV_PROTOCOL_MESSAGE_CMD];
+            JSON built = JSON::object();
+            for (const std::string& key : keys[i]) built[key] = message_cmd[key];
+            sink += built.size();
+        }
+    }
+    totals.build_ns[object] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_PASSES;
+
+    totals.lookups = 0;
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < BENCH_PASSES; ++pass)
+    {
+        for (std::size_t i = 0; i < parsed.size(); ++i)
+        {
+            const JSON& message_cmd = parsed[i][ANDRUAV_PROTOCOL_MESSAGE_CMD];
+            for (const std::string& key : keys[i])
+            {
+                sink += (message_cmd.find(key) != message_cmd.end()) ? 1 : 0;
+            }
+            totals.lookups += keys[i].size();
+        }
+    }
+    totals.lookups /= BENCH_PASSES;
+    totals.lookup_ns[object] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_PASSES;
+
+    totals.count = messages.size();
+    keep(&sink);
+}
+
+
+static void printRow (const char * name, const FLAT_TOTALS& totals)
+{
+    std::printf("%-8s %6zu", name, totals.count);
+    for (int object = 0; object < OBJECT_COUNT; ++object)
+    {
+        std::printf(" %8.0f %7.1f", totals.parse_ns[object] / totals.count,
+                    static_cast<double>(totals.parse_allocations[object]) / totals.count);
+    }
+    for (int object = 0; object < OBJECT_COUNT; ++object)
+    {
+        std::printf(" %8.0f", totals.build_ns[object] / totals.count);
+    }
+    for (int object = 0; object < OBJECT_COUNT; ++object)
+    {
+        std::printf(" %8.1f", (totals.lookups == 0) ? 0.0 : totals.lookup_ns[object] / totals.lookups);
+    }
+    std::printf("\n");
+}
+
+
+/**
+ * @brief object of field_count two character keys, as typical protocol fields.
+ */
+static std::string makeObject (const int field_count)
+{
+    std::string text = "{\"" ANDRUAV_PROTOCOL_MESSAGE_CMD "\":{";
+    for (int i = 0; i < field_count; ++i)
+    {
+        if (i != 0) text.push_back(',');
+        text += '"';
+        text.push_back(static_cast<char>('a' + (i % 26)));
+        text.push_back(static_cast<char>('A' + (i / 26)));
+        text += "\":" + std::to_string(i * 7);
+    }
+    text += "}}";
+    return text;
+}
+
+
+int main (int argc, char * argv[])
+{
+    const char * path = (argc > 1) ? argv[1] : CAPTURED_TRAFFIC_DEFAULT_PATH;
+
+    const std::vector<CAPTURED_MESSAGE> messages = readCapture(path);
+    if (messages.empty())
+    {
+        std::printf("no messages in %s\n", path);
+        return 1;
+    }
+
+    std::map<int, std::vector<std::string>> by_type;
+    std::vector<std::string> all_messages;
+    std::string text;
+    for (const CAPTURED_MESSAGE& message : messages)
+    {
+        serializeCaptured(text, DATABUS_ENCODING_JSON, message);
+        by_type[message.message_type].push_back(text);
+        all_messages.push_back(text);
+    }
+
+    const char * header = "%-8s %6s %8s %7s %8s %7s %8s %8s %8s %8s\n";
+    std::printf("%s: %zu messages. ns and heap allocations per message to parse, ns per message to build ms\n"
+                "key by key, ns per key looked up in ms\n", path, messages.size());
+    std::printf("%-8s %6s %16s %16s %17s %17s\n", "", "", "parse map", "parse flat", "build", "lookup");
+    std::printf(header, "type", "count", "ns", "allocs", "ns", "allocs", "map", "flat", "map", "flat");
+    for (const auto& [message_type, type_messages] : by_type)
+    {
+        FLAT_TOTALS totals {};
+        measure<nlohmann::json>(type_messages, OBJECT_MAP, totals);
+        measure<Json_de_flat>(type_messages, OBJECT_FLAT, totals);
+        printRow(std::to_string(message_type).c_str(), totals);
+    }
+    FLAT_TOTALS totals {};
+    measure<nlohmann::json>(all_messages, OBJECT_MAP, totals);
+    measure<Json_de_flat>(all_messages, OBJECT_FLAT, totals);
+    printRow("all", totals);
+
+    // lookup is a linear scan, so it falls behind std::map as objects grow.
+    std::printf("\ngenerated ms objects with two character keys\n");
+    std::printf(header, "keys", "count", "ns", "allocs", "ns", "allocs", "map", "flat", "map", "flat");
+    const int field_counts[] = {2, 4, 8, 16, 32, 64};
+    for (const int field_count : field_counts)
+    {
+        const std::vector<std::string> objects(100, makeObject(field_count));
+        FLAT_TOTALS object_totals {};
+        measure<nlohmann::json>(objects, OBJECT_MAP, object_totals);
+        measure<Json_de_flat>(objects, OBJECT_FLAT, object_totals);
+        printRow(std::to_string(field_count).c_str(), object_totals);
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+// Parses captured databus messages into nlohmann::json, into Json_de_arena on the heap and into
+// Json_de_arena inside the per thread CJsonArena as CInboundMessage does, then reads the ms fields
+// and destroys the DOM. Reports ns and heap allocations per message for each. See README.md.
+//
+// bench_json_arena [capture.jsonl]
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "count_allocations.hpp"
+#include "captured_traffic.hpp"
+
+using namespace de;
+using namespace de::comm;
+
+
+// each measurement runs over the messages of a type this many times.
+#define BENCH_PASSES        200
+
+
+typedef enum
+{
+    DOM_NLOHMANN        = 0,
+    DOM_ARENA_TYPE_HEAP = 1,
+    DOM_ARENA           = 2,
+    DOM_COUNT           = 3
+} ENUM_BENCH_DOM;
+
+
+typedef struct
+{
+    std::size_t count;
+    double ns[DOM_COUNT];
+    uint64_t allocations[DOM_COUNT];
+} ARENA_TOTALS;
+
+
+/**
+ * @brief what a message handler does with a received DOM: looks up ms and reads its fields.
+ */
+template <typename JSON>
+static std::size_t parseAndRead (const std::string& text)
+{
+    const JSON json = JSON::parse(text);
+    std::size_t fields = json.size();
+    const typename JSON::const_iterator message_cmd = json.find(ANDRUAV_PROTOCOL_MESSAGE_CMD);
+    if (message_cmd != json.end())
+    {
+        for (const auto& field : message_cmd->items())
+        {
+            fields += field.value().size();
+        }
+    }
+    return fields;
+}
+
+
+static std::size_t parseAndRead (const std::string& text, const ENUM_BENCH_DOM dom)
+{
+    if (dom == DOM_NLOHMANN) return parseAndRead<nlohmann::json>(text);
+    if (dom == DOM_ARENA_TYPE_HEAP) return parseAndRead<Json_de_arena>(text);
+
+    // as CInboundMessage: the arena is released when the DOM is gone.
+    CJsonArena& arena = CJsonArena::getThreadInstance();
+    arena.enter();
+    std::size_t fields;
+    {
+        CJsonArenaScope arena_scope(arena.getResource());
+        fields = parseAndRead<Json_de_arena>(text);
+    }
+    arena.leave();
+    return fields;
+}
+
+
+static void measure (const std::vector<std::string>& messages, ARENA_TOTALS& totals)
+{
+    totals.count = messages.size();
+    for (int dom = 0; dom < DOM_COUNT; ++dom)
+    {
+        std::size_t fields = 0;
+        const uint64_t start_allocations = allocations;
+        const auto start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < BENCH_PASSES; ++pass)
+        {
+            for (const std::string& message : messages)
+            {
+                fields += parseAndRead(message, static_cast<ENUM_BENCH_DOM>(dom));
+            }
+        }
+        totals.ns[dom] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_PASSES;
+        totals.allocations[dom] = (allocations - start_allocations) / BENCH_PASSES;
+        keep(&fields);
+    }
+}
+
+
+static void printRow (const char * name, const ARENA_TOTALS& totals)
+{
+    std::printf("%-8s %6zu", name, totals.count);
+    for (int dom = 0; dom < DOM_COUNT; ++dom)
+    {
+        std::printf(" %8.0f %7.1f", totals.ns[dom] / totals.count, static_cast<double>(totals.allocations[dom]) / totals.count);
+    }
+    std::printf(" %8.1f%%\n", 100.0 * totals.ns[DOM_ARENA] / totals.ns[DOM_NLOHMANN]);
+}
+
+
+int main (int argc, char * argv[])
+{
+    const char * path = (argc > 1) ? argv[1] : CAPTURED_TRAFFIC_DEFAULT_PATH;
+
+    const std::vector<CAPTURED_MESSAGE> messages = readCapture(path);
+    if (messages.empty())
+    {
+        std::printf("no messages in %s\n", path);
+        return 1;
+    }
+
+    // received as CModule sends them.
+    std::map<int, std::vector<std::string>> by_type;
+    std::vector<std::string> all_messages;
+    std::string text;
+    std::size_t largest = 0;
+    for (const CAPTURED_MESSAGE& message : messages)
+    {
+        serializeCaptured(text, DATABUS_ENCODING_JSON, message);
+        by_type[message.message_type].push_back(text);
+        all_messages.push_back(text);
+        largest = std::max(largest, text.size());
+    }
+
+    std::printf("%s: %zu messages, largest %zu bytes, arena buffer %d bytes per thread\n", path, messages.size(),
+                largest, JSON_ARENA_INITIAL_SIZE);
+    std::printf("ns and heap allocations per message to parse, read ms and destroy\n");
+    std::printf("%-8s %6s %16s %16s %16s %9s\n", "", "", "nlohmann::json", "arena type heap", "arena", "arena");
+    std::printf("%-8s %6s %8s %7s %8s %7s %8s %7s %9s\n", "type", "count", "ns", "allocs", "ns", "allocs", "ns", "allocs", "time");
+    for (const auto& [message_type, type_messages] : by_type)
+    {
+        ARENA_TOTALS totals {};
+        measure(type_messages, totals);
+        printRow(std::to_string(message_type).c_str(), totals);
+    }
+
+    ARENA_TOTALS totals {};
+    measure(all_messages, totals);
+    printRow("all", totals);
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Throughput of JSON_PARSER_NLOHMANN and JSON_PARSER_STRUCTURAL from 100 B to 1 MB.
+// Files given as arguments, e.g. captured messages, are measured instead. See README.md.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../de_databus/de_json_parser.hpp"
+
+using namespace de::comm;
+
+
+// bytes parsed per measurement, so small documents are repeated more.
+#define BENCH_BYTES_PER_RUN         (16 * 1024 * 1024)
+
+
+/**
+ * @brief telemetry like document of size bytes: objects with numbers, strings, nested arrays,
+ * then a padding string.
+ */
+static std::string makeDocument (const std::size_t size)
+{
+    std::string text = "{\"mt\":1036,\"ty\":\"uv\",\"ms\":[";
+    for (int i = 0; ; ++i)
+    {
+        char item[160];
+        std::snprintf(item, sizeof(item), "%s{\"i\":%d,\"la\":%.7f,\"ln\":%.7f,\"al\":%.2f,\"s\":\"wp_%d\",\"f\":[%d,true,null]}",
+                      (i == 0) ? "" : ",", i, 30.0444196 + i * 1e-6, 31.2357116 - i * 1e-6, 100.0 + i * 0.25, i, i & 7);
+        if (text.size() + std::char_traits<char>::length(item) + 16 > size) break;
+        text += item;
+    }
+    text += "],\"p\":\"";
+    text.append((size > text.size() + 2) ? size - text.size() - 2 : 0, 'x');
+    text += "\"}";
+    return text;
+}
+
+
+static double measure (const std::string& text, const ENUM_JSON_PARSER parser)
+{
+    const std::size_t repeat = (BENCH_BYTES_PER_RUN / text.size()) + 1;
+    std::size_t sink = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < repeat; ++i)
+    {
+        sink += parseJson(text.data(), text.data() + text.size(), parser).size();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (sink == 0) std::printf("empty documents\n");
+    return (static_cast<double>(text.size()) * repeat) / seconds / (1024.0 * 1024.0);
+}
+
+
+static void report (const std::string& name, const std::string& text)
+{
+    try
+    {
+        const double nlohmann = measure(text, JSON_PARSER_NLOHMANN);
+        const double structural = measure(text, JSON_PARSER_STRUCTURAL);
+        std::printf("%-24s %10zu %12.1f %12.1f %8.2fx\n", name.c_str(), text.size(), nlohmann, structural, structural / nlohmann);
+    }
+    catch (const Json_de::exception& e)
+    {
+        std::printf("%-24s %10zu %s\n", name.c_str(), text.size(), e.what());
+    }
+}
+
+
+int main (int argc, char * argv[])
+{
+    std::printf("structural index: %s\n", CJsonStructuralIndex::getImplementationName());
+    std::printf("%-24s %10s %12s %12s %9s\n", "document", "bytes", "nlohmann MB/s", "struct MB/s", "speedup");
+
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::ifstream file(argv[i], std::ios::binary);
+            report(argv[i], std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+        }
+    }
+    else
+    {
+        const std::size_t sizes[] = {100, 1024, 10 * 1024, 100 * 1024, 1024 * 1024};
+        for (const std::size_t size : sizes)
+        {
+            report("generated " + std::to_string(size), makeDocument(size));
+        }
+    }
+
+    std::printf("handed to nlohmann: %llu\n", static_cast<unsigned long long>(getJsonParserFallbackCount()));
+    return 0;
+}
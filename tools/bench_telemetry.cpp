@@ -0,0 +1,105 @@
+// Encode and decode cost per message of the binary telemetry codecs against the JSON "ms" path
+// they replace (toJson + dump, parse + fromJson). See README.md.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "../de_databus/de_telemetry_messages.hpp"
+
+using namespace de::comm;
+
+
+#define BENCH_MESSAGES      200000
+
+
+/**
+ * @brief keeps the compiler from dropping the work that wrote object.
+ */
+static inline void keep (const void * object)
+{
+    asm volatile("" : : "g"(object) : "memory");
+}
+
+
+template <typename F>
+static double measure (F&& step)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_MESSAGES; ++i) step(i);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_MESSAGES;
+}
+
+
+/**
+ * @param fill sets the fields of a message from the message index, so values change like real telemetry.
+ */
+template <typename T, typename FILL>
+static void report (const char * name, FILL&& fill)
+{
+    T telemetry;
+    T decoded;
+    char buffer[T::BINARY_SIZE];
+    std::string text;
+
+    const double binary_encode = measure([&](const int i) { fill(telemetry, i); telemetry.encode(buffer); keep(buffer); });
+    const double binary_decode = measure([&](const int i) { buffer[1] = static_cast<char>(i); decoded.decode(buffer, sizeof(buffer)); keep(&decoded); });
+
+    const double json_encode = measure([&](const int i) { fill(telemetry, i); text = telemetry.toJson().dump(); keep(&text); });
+    const double json_decode = measure([&](const int) { decoded.fromJson(Json_de::parse(text)); keep(&decoded); });
+
+    std::printf("%-16s %6zu %10.1f %10.1f %6zu %10.1f %10.1f\n", name, T::BINARY_SIZE, binary_encode, binary_decode,
+                text.size(), json_encode, json_decode);
+}
+
+
+int main ()
+{
+    std::printf("bytes of binary payload and of dumped ms section, ns per message over %d messages\n", BENCH_MESSAGES);
+    std::printf("%-16s %6s %10s %10s %6s %10s %10s\n", "message", "binary", "encode", "decode", "json", "encode", "decode");
+
+    report<CTelemetryGPS>("GPS", [](CTelemetryGPS& gps, const int i)
+    {
+        gps.fix_type = 3;
+        gps.satellites_count = static_cast<uint8_t>(10 + (i & 7));
+        gps.provider = 1;
+        gps.latitude = 30.0444196 + i * 1e-7;
+        gps.longitude = 31.2357116 - i * 1e-7;
+        gps.altitude = 110.25f + (i & 15) * 0.1f;
+        gps.relative_altitude = 50.5f + (i & 15) * 0.1f;
+        gps.yaw = static_cast<float>(i % 36000);
+    });
+
+    report<CTelemetryPower>("POWER", [](CTelemetryPower& power, const int i)
+    {
+        power.battery_voltage = 16.8f - (i & 255) * 0.001f;
+        power.battery_current = 12.5f + (i & 31) * 0.01f;
+        power.battery_remaining = static_cast<int8_t>(100 - (i % 100));
+        power.battery_temperature = 35.5f;
+        power.current_consumed = i * 0.01f;
+    });
+
+    report<CTelemetryNavInfo>("NAV_INFO", [](CTelemetryNavInfo& nav_info, const int i)
+    {
+        nav_info.roll = 0.01f * (i & 63);
+        nav_info.pitch = -0.02f * (i & 31);
+        nav_info.yaw = 1.5707963f;
+        nav_info.nav_roll = 2.5f;
+        nav_info.nav_pitch = -1.25f;
+        nav_info.nav_bearing = static_cast<float>(i % 360);
+        nav_info.target_bearing = static_cast<float>((i + 90) % 360);
+        nav_info.wp_dist = 250.0f - (i & 127);
+        nav_info.alt_error = 0.35f;
+    });
+
+    report<CTelemetryTrackingTargetLocation>("TRACKING", [](CTelemetryTrackingTargetLocation& tracking, const int i)
+    {
+        tracking.x = (i & 1023) / 1024.0f;
+        tracking.y = 0.5f;
+        tracking.width = 0.125f;
+        tracking.height = 0.0625f;
+        tracking.camera_direction = 1;
+    });
+
+    return 0;
+}
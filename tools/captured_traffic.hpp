@@ -0,0 +1,129 @@
+// Reading and re-serializing captured databus traffic for the replay tools. See README.md.
+
+#ifndef TOOLS_CAPTURED_TRAFFIC_H_
+#define TOOLS_CAPTURED_TRAFFIC_H_
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../de_databus/messages.hpp"
+#include "../de_databus/de_json_writer.hpp"
+#include "../de_databus/de_wire_encoding.hpp"
+
+
+// relative to the repository root. CMakeLists.txt defines the absolute path.
+#ifndef CAPTURED_TRAFFIC_DEFAULT_PATH
+#define CAPTURED_TRAFFIC_DEFAULT_PATH   "tools/data/databus_traffic.jsonl"
+#endif
+
+
+typedef struct
+{
+    std::string module_key;
+    int message_type;
+    std::string target_party_id;
+    std::string routing_type;
+    Json_de message_cmd;
+} CAPTURED_MESSAGE;
+
+
+/**
+ * @brief keeps the compiler from dropping the work that wrote object.
+ */
+static inline void keep (const void * object)
+{
+    asm volatile("" : : "g"(object) : "memory");
+}
+
+
+/**
+ * @brief one message per line. Lines that are not databus messages are reported and skipped.
+ */
+static std::vector<CAPTURED_MESSAGE> readCapture (const char * path)
+{
+    std::vector<CAPTURED_MESSAGE> messages;
+    std::ifstream file(path);
+    std::string line;
+    std::size_t line_number = 0;
+    while (std::getline(file, line))
+    {
+        ++line_number;
+        if (line.empty()) continue;
+        try
+        {
+            const Json_de json = Json_de::parse(line);
+            messages.push_back({json.value(INTERMODULE_MODULE_KEY, ""), json.at(ANDRUAV_PROTOCOL_MESSAGE_TYPE).get<int>(),
+                                json.value(ANDRUAV_PROTOCOL_TARGET_ID, ""), json.value(INTERMODULE_ROUTING_TYPE, ""),
+                                json.value(ANDRUAV_PROTOCOL_MESSAGE_CMD, Json_de::object())});
+        }
+        catch (const Json_de::exception& e)
+        {
+            std::printf("%s:%zu skipped: %s\n", path, line_number, e.what());
+        }
+    }
+    return messages;
+}
+
+
+/**
+ * @brief message as CModule serializes it. JSON fields are written as GU, mt, tg, ty, ms then dl.
+ * @param message_cmd sent instead of message.message_cmd if not null, e.g. a delta.
+ * @param delta_header written as @link INTERMODULE_DELTA_HEADER @endlink if not null.
+ * @param aliases non zero aliases are written as GA and ta instead of GU and tg.
+ */
+static void serializeCaptured (std::string& out, const ENUM_DATABUS_ENCODING encoding, const CAPTURED_MESSAGE& message,
+                               const Json_de * message_cmd = nullptr, const DELTA_HEADER * delta_header = nullptr,
+                               const SESSION_ALIASES * aliases = nullptr)
+{
+    const Json_de& cmd = (message_cmd != nullptr) ? *message_cmd : message.message_cmd;
+    if (encoding != DATABUS_ENCODING_JSON)
+    {
+        de::comm::serializeEncodedMessage(out, encoding, message.module_key, message.message_type, message.target_party_id,
+                                          message.routing_type, cmd, delta_header, aliases);
+        return;
+    }
+
+    out.clear();
+    if ((aliases != nullptr) && (aliases->module_key != 0))
+    {
+        out += "{\"" INTERMODULE_MODULE_KEY_ALIAS "\":";
+        out += std::to_string(aliases->module_key);
+    }
+    else
+    {
+        out += "{\"" INTERMODULE_MODULE_KEY "\":";
+        de::comm::appendJsonString(out, message.module_key);
+    }
+    out += ",\"" ANDRUAV_PROTOCOL_MESSAGE_TYPE "\":";
+    out += std::to_string(message.message_type);
+    if ((aliases != nullptr) && (aliases->target_party != 0))
+    {
+        out += ",\"" INTERMODULE_TARGET_ID_ALIAS "\":";
+        out += std::to_string(aliases->target_party);
+    }
+    else
+    {
+        out += ",\"" ANDRUAV_PROTOCOL_TARGET_ID "\":";
+        de::comm::appendJsonString(out, message.target_party_id);
+    }
+    out += ",\"" INTERMODULE_ROUTING_TYPE "\":";
+    de::comm::appendJsonString(out, message.routing_type);
+    out += ",\"" ANDRUAV_PROTOCOL_MESSAGE_CMD "\":";
+    de::comm::appendJson(out, cmd);
+    if (delta_header != nullptr)
+    {
+        out += ",\"" INTERMODULE_DELTA_HEADER "\":[";
+        out += std::to_string(delta_header->sequence);
+        if (!delta_header->keyframe)
+        {
+            out.push_back(',');
+            out += std::to_string(delta_header->base_sequence);
+        }
+        out.push_back(']');
+    }
+    out.push_back('}');
+}
+
+#endif
@@ -0,0 +1,176 @@
+// Size and CPU cost of JSON, CBOR and MessagePack envelopes for captured databus traffic, per
+// message type, then their size with session aliases. Reads one JSON message per line,
+// tools/data/databus_traffic.jsonl by default. See README.md.
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "captured_traffic.hpp"
+
+using namespace de::comm;
+
+
+// each measurement runs over the whole capture this many times.
+#define BENCH_PASSES                50
+
+
+typedef struct
+{
+    std::size_t count;
+    std::size_t bytes[3];
+    double encode_ns[3];
+    double decode_ns[3];
+    // with SESSION_ALIASES: GA and ta instead of GU and tg.
+    std::size_t aliased_bytes[3];
+} ENCODING_TOTALS;
+
+
+/**
+ * @brief parses into the DOM a receiver gets: Json_de::parse for JSON text, decodeFrame for frames.
+ */
+static void deserialize (const std::string& in, std::string& text, Json_de& json)
+{
+    if (isEncodedFrame(in.data(), in.size()))
+    {
+        if (!decodeFrame(in.data(), in.size(), text, &json)) std::printf("malformed frame\n");
+        return;
+    }
+    json = Json_de::parse(in);
+}
+
+
+static void printRow (const char * name, const ENCODING_TOTALS& totals)
+{
+    std::printf("%-10s %6zu", name, totals.count);
+    for (int encoding = 0; encoding < 3; ++encoding)
+    {
+        std::printf(" %7.1f %7.0f %7.0f", static_cast<double>(totals.bytes[encoding]) / totals.count,
+                    totals.encode_ns[encoding] / totals.count, totals.decode_ns[encoding] / totals.count);
+    }
+    std::printf("\n");
+}
+
+
+static void printAliasedRow (const char * name, const ENCODING_TOTALS& totals)
+{
+    std::printf("%-10s %6zu", name, totals.count);
+    for (int encoding = 0; encoding < 3; ++encoding)
+    {
+        std::printf(" %7.1f %7.1f %6.1f%%", static_cast<double>(totals.bytes[encoding]) / totals.count,
+                    static_cast<double>(totals.aliased_bytes[encoding]) / totals.count,
+                    100.0 * totals.aliased_bytes[encoding] / totals.bytes[encoding]);
+    }
+    std::printf("\n");
+}
+
+
+/**
+ * @brief aliases as the communicator assigns them: numbered from 1 in order of first use.
+ * @details group and intermodule messages have no target and keep no target alias.
+ */
+static SESSION_ALIASES getAliases (const CAPTURED_MESSAGE& message, std::map<std::string, uint16_t>& module_aliases,
+                                   std::map<std::string, uint16_t>& party_aliases)
+{
+    SESSION_ALIASES aliases = {0, 0};
+    aliases.module_key = module_aliases.emplace(message.module_key, static_cast<uint16_t>(module_aliases.size() + 1)).first->second;
+    if (!message.target_party_id.empty())
+    {
+        aliases.target_party = party_aliases.emplace(message.target_party_id, static_cast<uint16_t>(party_aliases.size() + 1)).first->second;
+    }
+    return aliases;
+}
+
+
+int main (int argc, char * argv[])
+{
+    const char * path = (argc > 1) ? argv[1] : CAPTURED_TRAFFIC_DEFAULT_PATH;
+    const std::vector<CAPTURED_MESSAGE> messages = readCapture(path);
+    if (messages.empty())
+    {
+        std::printf("no messages in %s\n", path);
+        return 1;
+    }
+
+    const ENUM_DATABUS_ENCODING encodings[3] = {DATABUS_ENCODING_JSON, DATABUS_ENCODING_CBOR, DATABUS_ENCODING_MSGPACK};
+    std::map<int, ENCODING_TOTALS> by_type;
+    ENCODING_TOTALS all {};
+
+    std::string out;
+    std::string text;
+    Json_de json;
+    std::map<std::string, uint16_t> module_aliases;
+    std::map<std::string, uint16_t> party_aliases;
+    for (int encoding = 0; encoding < 3; ++encoding)
+    {
+        for (const CAPTURED_MESSAGE& message : messages)
+        {
+            const SESSION_ALIASES aliases = getAliases(message, module_aliases, party_aliases);
+            serializeCaptured(out, encodings[encoding], message, nullptr, nullptr, &aliases);
+            const std::size_t aliased_bytes = out.size();
+            deserialize(out, text, json);
+            if ((json[ANDRUAV_PROTOCOL_MESSAGE_CMD] != message.message_cmd) || (json[INTERMODULE_MODULE_KEY_ALIAS] != aliases.module_key))
+            {
+                std::printf("%s message %d with aliases does not round trip\n", getEncodingName(encodings[encoding]), message.message_type);
+            }
+
+            ENCODING_TOTALS& totals = by_type[message.message_type];
+
+            auto start = std::chrono::steady_clock::now();
+            for (int pass = 0; pass < BENCH_PASSES; ++pass) { serializeCaptured(out, encodings[encoding], message); keep(&out); }
+            const double encode_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_PASSES;
+
+            start = std::chrono::steady_clock::now();
+            for (int pass = 0; pass < BENCH_PASSES; ++pass) { deserialize(out, text, json); keep(&json); }
+            const double decode_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / BENCH_PASSES;
+
+            if (json[ANDRUAV_PROTOCOL_MESSAGE_CMD] != message.message_cmd)
+            {
+                std::printf("%s message %d does not round trip\n", getEncodingName(encodings[encoding]), message.message_type);
+            }
+
+            for (ENCODING_TOTALS * target : {&totals, &all})
+            {
+                if (encoding == 0) ++target->count;
+                target->bytes[encoding] += out.size();
+                target->encode_ns[encoding] += encode_ns;
+                target->decode_ns[encoding] += decode_ns;
+                target->aliased_bytes[encoding] += aliased_bytes;
+            }
+        }
+    }
+
+    std::printf("%s: %zu messages. Average bytes, encode ns and decode ns per message\n", path, messages.size());
+    std::printf("%-10s %6s %23s %23s %23s\n", "type", "count", "json", getEncodingName(DATABUS_ENCODING_CBOR), getEncodingName(DATABUS_ENCODING_MSGPACK));
+    std::printf("%-17s", "");
+    for (int encoding = 0; encoding < 3; ++encoding) std::printf(" %7s %7s %7s", "bytes", "encode", "decode");
+    std::printf("\n");
+    for (const auto& [message_type, totals] : by_type)
+    {
+        printRow(std::to_string(message_type).c_str(), totals);
+    }
+    printRow("all", all);
+
+    std::printf("total bytes: json %zu, %s %zu (%.1f%%), %s %zu (%.1f%%)\n", all.bytes[0],
+                getEncodingName(DATABUS_ENCODING_CBOR), all.bytes[1], 100.0 * all.bytes[1] / all.bytes[0],
+                getEncodingName(DATABUS_ENCODING_MSGPACK), all.bytes[2], 100.0 * all.bytes[2] / all.bytes[0]);
+
+    std::printf("\nwith session aliases: %zu module keys and %zu target parties numbered from 1. Average bytes without, with\n",
+                module_aliases.size(), party_aliases.size());
+    std::printf("%-10s %6s %22s %22s %22s\n", "type", "count", "json", getEncodingName(DATABUS_ENCODING_CBOR), getEncodingName(DATABUS_ENCODING_MSGPACK));
+    std::printf("%-17s", "");
+    for (int encoding = 0; encoding < 3; ++encoding) std::printf(" %7s %7s %6s", "bytes", "aliased", "");
+    std::printf("\n");
+    for (const auto& [message_type, totals] : by_type)
+    {
+        printAliasedRow(std::to_string(message_type).c_str(), totals);
+    }
+    printAliasedRow("all", all);
+
+    std::printf("total bytes with aliases: json %zu, %s %zu (%.1f%%), %s %zu (%.1f%%) of json without aliases\n", all.aliased_bytes[0],
+                getEncodingName(DATABUS_ENCODING_CBOR), all.aliased_bytes[1], 100.0 * all.aliased_bytes[1] / all.bytes[0],
+                getEncodingName(DATABUS_ENCODING_MSGPACK), all.aliased_bytes[2], 100.0 * all.aliased_bytes[2] / all.bytes[0]);
+    return 0;
+}
@@ -0,0 +1,44 @@
+// Counts heap allocations by replacing the global operator new. Include it in one source file
+// of a program only. See README.md.
+
+#ifndef TOOLS_COUNT_ALLOCATIONS_H_
+#define TOOLS_COUNT_ALLOCATIONS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+
+// operator new calls made by any thread of the program so far.
+static std::atomic<uint64_t> allocations{0};
+
+
+// the replacements below pair malloc with free, which g++ cannot see through once inlined.
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void * operator new (std::size_t size)
+{
+    ++allocations;
+    void * memory = std::malloc((size == 0) ? 1 : size);
+    if (memory == nullptr) throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete (void * memory) noexcept { std::free(memory); }
+void operator delete (void * memory, std::size_t) noexcept { std::free(memory); }
+
+// std::pmr::new_delete_resource() allocates through the aligned forms.
+void * operator new (std::size_t size, std::align_val_t alignment)
+{
+    ++allocations;
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    void * memory = std::aligned_alloc(align, ((size + align - 1) / align) * align + ((size == 0) ? align : 0));
+    if (memory == nullptr) throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete (void * memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete (void * memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+#endif
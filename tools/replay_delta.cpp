@@ -0,0 +1,186 @@
+// Replays captured databus traffic through CDeltaEncoder, a lossy link and CDeltaDecoder. Reports bytes
+// saved per message type and, for several keyframe intervals, references and loss rates, how many
+// deltas are dropped. Every rebuilt message is checked against the original. See README.md.
+//
+// replay_delta [capture.jsonl] [keyframe interval] [previous|keyframe] [loss percent] [json|cbor|msgpack]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "captured_traffic.hpp"
+#include "../de_databus/de_delta_codec.hpp"
+
+using namespace de::comm;
+
+
+#define REPLAY_DEFAULT_KEYFRAME_INTERVAL    10
+
+
+typedef struct
+{
+    std::size_t count;
+    std::size_t keyframes;
+    std::size_t full_bytes;
+    std::size_t sent_bytes;
+    // messages the link lost and deltas dropped by the receiver because their base was lost.
+    std::size_t lost;
+    std::size_t dropped;
+    // rebuilt messages that differ from the original. Must stay 0.
+    std::size_t mismatched;
+    double encode_ns;
+    double decode_ns;
+} REPLAY_TOTALS;
+
+
+/**
+ * @brief sends every message delta encoded and drops each one with probability loss_percent.
+ * @details messages are replayed back to back, so keyframe_period_ms has no effect and only the
+ * keyframe interval starts keyframes.
+ */
+static REPLAY_TOTALS replay (const std::vector<CAPTURED_MESSAGE>& messages, const ENUM_DATABUS_ENCODING encoding,
+                             const DELTA_ENCODING_CONFIG& config, const double loss_percent,
+                             std::map<int, REPLAY_TOTALS> * by_type = nullptr)
+{
+    CPartyTable party_table;
+    // each sending module has its own encoder.
+    std::map<std::string, CDeltaEncoder> encoders;
+    CDeltaDecoder decoder;
+    REPLAY_TOTALS all {};
+
+    // same link losses for every configuration.
+    uint64_t seed = 1;
+    auto next = [&seed]() { seed = seed * 6364136223846793005ULL + 1442695040888963407ULL; return seed >> 33; };
+
+    std::string full;
+    std::string sent;
+    std::string text;
+    Json_de received;
+    for (const CAPTURED_MESSAGE& message : messages)
+    {
+        REPLAY_TOTALS totals {};
+        serializeCaptured(full, encoding, message);
+
+        auto start = std::chrono::steady_clock::now();
+        DELTA_HEADER header;
+        const Json_de& message_cmd = encoders[message.module_key].encode(party_table.intern(message.target_party_id),
+                                                                         message.message_type, message.message_cmd, config, header);
+        serializeCaptured(sent, encoding, message, &message_cmd, &header);
+        totals.encode_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        ++totals.count;
+        totals.keyframes += header.keyframe ? 1 : 0;
+        totals.full_bytes += full.size();
+        totals.sent_bytes += sent.size();
+
+        if (static_cast<double>(next() % 10000) < loss_percent * 100.0)
+        {
+            ++totals.lost;
+        }
+        else
+        {
+            start = std::chrono::steady_clock::now();
+            if (isEncodedFrame(sent.data(), sent.size()))
+            {
+                decodeFrame(sent.data(), sent.size(), text, &received);
+            }
+            else
+            {
+                received = Json_de::parse(sent);
+            }
+            Json_de& received_cmd = received[ANDRUAV_PROTOCOL_MESSAGE_CMD];
+            const std::string stream_key = message.module_key + '/' + message.target_party_id + '/' + std::to_string(message.message_type);
+            if (!decoder.decode(stream_key, header, received_cmd))
+            {
+                ++totals.dropped;
+            }
+            else if (received_cmd != message.message_cmd)
+            {
+                ++totals.mismatched;
+            }
+            totals.decode_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        for (REPLAY_TOTALS * target : {&all, (by_type != nullptr) ? &(*by_type)[message.message_type] : nullptr})
+        {
+            if (target == nullptr) continue;
+            target->count += totals.count;
+            target->keyframes += totals.keyframes;
+            target->full_bytes += totals.full_bytes;
+            target->sent_bytes += totals.sent_bytes;
+            target->lost += totals.lost;
+            target->dropped += totals.dropped;
+            target->mismatched += totals.mismatched;
+            target->encode_ns += totals.encode_ns;
+            target->decode_ns += totals.decode_ns;
+        }
+    }
+    return all;
+}
+
+
+static void printTypeRow (const char * name, const REPLAY_TOTALS& totals)
+{
+    std::printf("%-10s %6zu %9zu %9.1f %9.1f %7.1f%% %8.0f %8.0f %8zu\n", name, totals.count, totals.keyframes,
+                static_cast<double>(totals.full_bytes) / totals.count, static_cast<double>(totals.sent_bytes) / totals.count,
+                100.0 * totals.sent_bytes / totals.full_bytes, totals.encode_ns / totals.count,
+                (totals.count > totals.lost) ? totals.decode_ns / (totals.count - totals.lost) : 0.0, totals.mismatched);
+}
+
+
+int main (int argc, char * argv[])
+{
+    const char * path = (argc > 1) ? argv[1] : CAPTURED_TRAFFIC_DEFAULT_PATH;
+    const uint32_t keyframe_interval = (argc > 2) ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : REPLAY_DEFAULT_KEYFRAME_INTERVAL;
+    const ENUM_DELTA_REFERENCE reference = ((argc > 3) && (std::strcmp(argv[3], "keyframe") == 0)) ? DELTA_REFERENCE_KEYFRAME : DELTA_REFERENCE_PREVIOUS;
+    const double loss_percent = (argc > 4) ? std::strtod(argv[4], nullptr) : 0.0;
+    const ENUM_DATABUS_ENCODING encoding = (argc > 5) ? getEncodingByName(argv[5]) : DATABUS_ENCODING_JSON;
+
+    const std::vector<CAPTURED_MESSAGE> messages = readCapture(path);
+    if (messages.empty())
+    {
+        std::printf("no messages in %s\n", path);
+        return 1;
+    }
+
+    const char * encoding_name = (encoding == DATABUS_ENCODING_JSON) ? "json" : getEncodingName(encoding);
+    const char * reference_names[] = {"previous", "keyframe"};
+
+    std::map<int, REPLAY_TOTALS> by_type;
+    const REPLAY_TOTALS all = replay(messages, encoding, {keyframe_interval, 0, reference}, loss_percent, &by_type);
+
+    std::printf("%s: %zu messages as %s, every type delta encoded. keyframe interval %u, reference %s, loss %.1f%%\n",
+                path, messages.size(), encoding_name, keyframe_interval, reference_names[reference], loss_percent);
+    std::printf("%-10s %6s %9s %9s %9s %8s %8s %8s %8s\n", "type", "count", "keyframes", "full B", "sent B", "sent",
+                "enc ns", "dec ns", "mismatch");
+    for (const auto& [message_type, totals] : by_type)
+    {
+        printTypeRow(std::to_string(message_type).c_str(), totals);
+    }
+    printTypeRow("all", all);
+
+    std::printf("\n%-9s %8s %6s %7s %10s %10s %8s\n", "reference", "interval", "loss", "sent", "lost", "dropped", "mismatch");
+    const uint32_t intervals[] = {5, 10, 25, 50};
+    const double losses[] = {0.0, 1.0, 5.0};
+    std::size_t mismatched = all.mismatched;
+    for (const ENUM_DELTA_REFERENCE sweep_reference : {DELTA_REFERENCE_PREVIOUS, DELTA_REFERENCE_KEYFRAME})
+    {
+        for (const uint32_t interval : intervals)
+        {
+            for (const double loss : losses)
+            {
+                const REPLAY_TOTALS totals = replay(messages, encoding, {interval, 0, sweep_reference}, loss);
+                std::printf("%-9s %8u %5.1f%% %6.1f%% %10zu %10zu %8zu\n", reference_names[sweep_reference], interval, loss,
+                            100.0 * totals.sent_bytes / totals.full_bytes, totals.lost, totals.dropped, totals.mismatched);
+                mismatched += totals.mismatched;
+            }
+        }
+    }
+
+    return (mismatched == 0) ? 0 : 1;
+}
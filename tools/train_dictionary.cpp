@@ -0,0 +1,148 @@
+// Trains a zstd dictionary for setDictionaryCompression() from captured databus traffic and reports
+// how it compresses messages held out of training. Needs DE_ENABLE_ZSTD. See README.md.
+//
+// train_dictionary [capture.jsonl] [dictionary file] [dictionary size] [json|cbor|msgpack]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "captured_traffic.hpp"
+
+using namespace de::comm;
+
+
+#ifndef TRAIN_DEFAULT_DICTIONARY_PATH
+#define TRAIN_DEFAULT_DICTIONARY_PATH   "tools/data/databus_traffic.dict"
+#endif
+#define TRAIN_DEFAULT_DICTIONARY_SIZE   (16 * 1024)
+
+// every TRAIN_HOLDOUT_EVERY th message is kept out of training and used to evaluate the dictionary.
+#define TRAIN_HOLDOUT_EVERY             5
+
+// each measurement runs over the held out messages this many times.
+#define BENCH_PASSES                    50
+
+
+/**
+ * @brief bytes sent for the held out messages when messages of at least min_size bytes are compressed.
+ */
+static void reportMinSize (const std::vector<std::string>& messages, const CDictionaryCodec& codec, const std::size_t min_size)
+{
+    std::size_t original_bytes = 0;
+    std::size_t sent_bytes = 0;
+    std::size_t compressed = 0;
+    std::string frame;
+    for (const std::string& message : messages)
+    {
+        frame = message;
+        if (compressFrame(frame, codec, min_size)) ++compressed;
+        original_bytes += message.size();
+        sent_bytes += frame.size();
+    }
+    std::printf("%8zu %10zu %10zu %10zu %7.1f%%\n", min_size, compressed, original_bytes, sent_bytes, 100.0 * sent_bytes / original_bytes);
+}
+
+
+int main (int argc, char * argv[])
+{
+    const char * capture_path = (argc > 1) ? argv[1] : CAPTURED_TRAFFIC_DEFAULT_PATH;
+    const char * dictionary_path = (argc > 2) ? argv[2] : TRAIN_DEFAULT_DICTIONARY_PATH;
+    const std::size_t dictionary_size = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : TRAIN_DEFAULT_DICTIONARY_SIZE;
+    const ENUM_DATABUS_ENCODING encoding = (argc > 4) ? getEncodingByName(argv[4]) : DATABUS_ENCODING_JSON;
+
+    const std::vector<CAPTURED_MESSAGE> messages = readCapture(capture_path);
+
+    // samples are what compressFrame() compresses: JSON text or the envelope of a frame.
+    std::vector<std::string> samples;
+    std::vector<std::string> held_out;
+    std::string out;
+    for (std::size_t i = 0; i < messages.size(); ++i)
+    {
+        serializeCaptured(out, encoding, messages[i]);
+        if ((i % TRAIN_HOLDOUT_EVERY) == (TRAIN_HOLDOUT_EVERY - 1))
+        {
+            held_out.push_back(out);
+        }
+        else
+        {
+            samples.push_back(out.substr(isEncodedFrame(out.data(), out.size()) ? DATABUS_FRAME_HEADER_SIZE : 0));
+        }
+    }
+
+    std::string dictionary;
+    if (!CDictionaryCodec::train(samples, dictionary_size, dictionary))
+    {
+        std::printf("training failed: %zu samples. Needs DE_ENABLE_ZSTD and samples of many times the dictionary size\n", samples.size());
+        return 1;
+    }
+
+    CDictionaryCodec codec;
+    if (!codec.load(dictionary))
+    {
+        std::printf("trained dictionary does not load\n");
+        return 1;
+    }
+
+    std::ofstream file(dictionary_path, std::ios::binary);
+    file.write(dictionary.data(), static_cast<std::streamsize>(dictionary.size()));
+    if (!file)
+    {
+        std::printf("cannot write %s\n", dictionary_path);
+        return 1;
+    }
+
+    std::printf("%s: %zu messages as %s, %zu trained, %zu held out\n", capture_path, messages.size(),
+                (encoding == DATABUS_ENCODING_JSON) ? "json" : getEncodingName(encoding), samples.size(), held_out.size());
+    std::printf("%s: %zu bytes, dictionary id %u\n", dictionary_path, dictionary.size(), codec.getDictionaryId());
+
+    std::printf("%8s %10s %10s %10s %8s\n", "min_size", "compressed", "bytes", "sent", "ratio");
+    const std::size_t min_sizes[] = {0, 64, 128, 256, 512};
+    for (const std::size_t min_size : min_sizes)
+    {
+        reportMinSize(held_out, codec, min_size);
+    }
+
+    std::vector<std::string> compressed(held_out.size());
+    std::string decompressed;
+    std::size_t total_bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < BENCH_PASSES; ++pass)
+    {
+        for (std::size_t i = 0; i < held_out.size(); ++i)
+        {
+            const std::size_t offset = isEncodedFrame(held_out[i].data(), held_out[i].size()) ? DATABUS_FRAME_HEADER_SIZE : 0;
+            compressed[i].clear();
+            codec.compress(held_out[i].data() + offset, held_out[i].size() - offset, compressed[i]);
+            keep(&compressed[i]);
+            total_bytes += held_out[i].size() - offset;
+        }
+    }
+    const double compress_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < BENCH_PASSES; ++pass)
+    {
+        for (std::size_t i = 0; i < compressed.size(); ++i)
+        {
+            const std::size_t offset = isEncodedFrame(held_out[i].data(), held_out[i].size()) ? DATABUS_FRAME_HEADER_SIZE : 0;
+            decompressed.clear();
+            const bool decoded = codec.decompress(compressed[i].data(), compressed[i].size(), decompressed);
+            if (!decoded || ((pass == 0) && (held_out[i].compare(offset, std::string::npos, decompressed) != 0)))
+            {
+                std::printf("message does not round trip\n");
+                return 1;
+            }
+            keep(&decompressed);
+        }
+    }
+    const double decompress_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    const std::size_t count = held_out.size() * BENCH_PASSES;
+    std::printf("ns per message: compress %.0f, decompress %.0f. compress %.1f MB/s\n", compress_ns / count,
+                decompress_ns / count, total_bytes / (compress_ns / 1e9) / (1024.0 * 1024.0));
+    return 0;
+}